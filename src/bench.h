@@ -0,0 +1,30 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+// loop() stages timed by tools/simavr_bench. The env:uno_bench build (-DBENCH) writes the
+// stage starting to GPIOR0, an otherwise unused register the simulator watches, one out
+// instruction per mark. Other builds compile the marks out.
+// Plain C so the host harness can include it for the stage numbers.
+
+enum BENCH_STAGE {
+  BENCH_SETUP, // before the first loop()
+  BENCH_SERIAL, // first stage, marks the start of every loop()
+  BENCH_ROTARY,
+  BENCH_BOOT,
+  BENCH_STANDBY,
+  BENCH_CONTROL,
+  BENCH_ENERGY,
+  BENCH_LCD,
+  BENCH_HOUSEKEEPING, // timeouts, auto restore, adaptation, plotter, beep
+  BENCH_STAGES
+};
+
+#define BENCH_MARK_ADDRESS 0x3E // GPIOR0 in the data space
+
+#ifdef BENCH
+#define BENCH_MARK(stage) (GPIOR0 = (stage))
+#else
+#define BENCH_MARK(stage)
+#endif
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+// Building blocks for the board profiles in config.h. Everything here is evaluated
+// by the compiler: a profile only leaves constants and tables in the binary.
+// C++11 constexpr, one return statement per function.
+
+#include <Arduino.h>
+
+#define NO_PIN 0xFF // profile has no such pin, the code using it is compiled out
+
+constexpr double constexprSquare(double x) { return x * x; }
+
+// Taylor series, good for |x| <= 0.5
+constexpr double constexprExpSeries(double x, int n, double term, double sum) {
+  return (n > 12) ? sum : constexprExpSeries(x, n + 1, term * x / n, sum + term * x / n);
+}
+
+// e^x, halves x until the series converges fast then squares back
+constexpr double constexprExp(double x) {
+  return (x > 0.5 || x < -0.5) ? constexprSquare(constexprExp(x / 2)) : constexprExpSeries(x, 1, 1, 1);
+}
+
+// NTC thermistor to ground with a series resistor to the ADC reference (beta model).
+// SAMPLES readings are summed for each measurement.
+template <uint32_t NOMINAL, uint32_t SERIES, uint16_t BETA, uint8_t NOMINAL_TEMP, uint8_t ADC_BITS, uint8_t SAMPLES>
+struct NtcThermistor {
+  static constexpr uint8_t samples = SAMPLES;
+  static constexpr uint16_t adcMax = (1 << ADC_BITS) - 1;
+
+  static constexpr double resistanceAt(double celsius) {
+    return NOMINAL * constexprExp(BETA * (1 / (celsius + 273.15) - 1 / (NOMINAL_TEMP + 273.15)));
+  }
+  // sum of SAMPLES ADC readings with the thermistor at celsius
+  static constexpr uint16_t adcSumAt(double celsius) {
+    return (uint16_t)((double)SAMPLES * adcMax * resistanceAt(celsius) / (resistanceAt(celsius) + SERIES) + 0.5);
+  }
+
+  static_assert((uint32_t)SAMPLES * ((1 << ADC_BITS) - 1) <= 0xFFFF, "sample sum must fit 16 bits");
+};
+
+// Heater PWM driven by analogWrite(). Timer 2 runs phase correct PWM and its prescaler
+// sets the frequency, timer 0 also runs millis() so it must stay at 64. PIN must be a
+// compare output of TIMER.
+template <uint8_t PIN, uint8_t TIMER, uint16_t PRESCALER, uint8_t BITS> struct HeaterPwm {
+  static constexpr uint8_t pin = PIN;
+  static constexpr uint8_t timer = TIMER;
+  static constexpr uint16_t pwmMax = (1 << BITS) - 1;
+  // timer 2 clock select bits for the prescaler
+  static constexpr uint8_t clockSelect = (PRESCALER == 1)     ? 1
+                                         : (PRESCALER == 8)   ? 2
+                                         : (PRESCALER == 32)  ? 3
+                                         : (PRESCALER == 64)  ? 4
+                                         : (PRESCALER == 128) ? 5
+                                         : (PRESCALER == 256) ? 6
+                                                              : 7;
+  // phase correct counts up and down (510 ticks), fast PWM on timer 0 counts 256
+  static constexpr uint32_t periodMicros = (uint32_t)PRESCALER * ((TIMER == 2) ? 510 : 256) / (F_CPU / 1000000UL);
+
+  static_assert(TIMER == 2 || (TIMER == 0 && PRESCALER == 64), "heater pwm on timer 2, or timer 0 at its millis() prescaler");
+  static_assert(PRESCALER == 1 || PRESCALER == 8 || PRESCALER == 32 || PRESCALER == 64 || PRESCALER == 128 ||
+                    PRESCALER == 256 || PRESCALER == 1024,
+                "not a timer 2 prescaler");
+  static_assert(BITS == 8, "analogWrite() is 8 bit, Output and maxPower are 0-255");
+  // atmega328 compare outputs: OC2A 11, OC2B 3, OC0A 6, OC0B 5
+  static_assert((TIMER == 2 && (PIN == 3 || PIN == 11)) || (TIMER == 0 && (PIN == 5 || PIN == 6)),
+                "heater pin is not a pwm output of its timer");
+  static_assert(PIN != 11, "pin 11 is the hardware SPI MOSI of the lcd");
+};
+
+#endif
@@ -1,36 +1,117 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
-// PINS 
+#include "board.h"
 
-#define HEATER_PIN 3 // must be PWM capable
-#define SENSOR_PIN A0 
-#define BUZZER_PIN 5
+// BOARD PROFILES
+// one struct per hardware variant, platformio.ini picks it with -DBOARD_... per environment
 
-#define LCD_CS 10
-#define LCD_A0 9
-#define LCD_RST 8
+// DEFAULT_SETTINGS, shared by the profiles, a profile overrides a value by declaring it again
+struct UsbIronDefaults {
+  static constexpr double standbyTemp = 150;    // Celsius
+  static constexpr uint16_t standbyTime = 60;   // seconds
+  static constexpr double p = 4.5;              // proportional
+  static constexpr double i = 0;                // integral
+  static constexpr double d = 2.0;              // derivatinve
+  static constexpr double m1 = 300;             // memory M1
+  static constexpr double m2 = 260;             // memory M2
+  static constexpr double m3 = 350;             // memory M3
+  static constexpr double tCorrection = 0.85;   // tip's temperature relative to thermistor reading
+  static constexpr uint8_t maxPower = 220;      // 0-255 max PWM output power (0-100% in the menu)
+  static constexpr uint16_t timeout = 30;       // minutes before shutoff
+  static constexpr uint16_t deepStandbyTime1 = 300; // seconds in standby before the 2nd stage, 0 ends the ladder
+  static constexpr uint16_t deepStandbyTemp1 = 120; // Celsius
+  static constexpr uint16_t deepStandbyTime2 = 600; // seconds in the 2nd stage before the 3rd
+  static constexpr uint16_t deepStandbyTemp2 = 80;  // Celsius
+  static constexpr bool sound = true;           // false to disable
+  static constexpr bool restore = true;         // restore froms standby false MANUAL(by clicking), true AUTO (by temperature variation)
+  static constexpr uint8_t rampRate = 30;       // max setpoint slope in Celsius/s, 0 jumps straight to the new setpoint
+  static constexpr uint8_t rampProfile = 2;     // 0 STEP, 1 LINEAR, 2 S-CURVE
+  static constexpr double rampAccel = 60;       // S-curve setpoint acceleration in Celsius/s^2
+  static constexpr bool adaptive = false;       // PID gains follow the identified plant, needs a reference (ai:1)
 
+  // heater, used for the energy accounting
+  static constexpr double heaterResistance = 3.2; // ohms, measured cold on the iron's heater wires
+  static constexpr double supplyVoltage = 5.0;    // volts at the heater with the mosfet on
+  static constexpr double heaterWatts = supplyVoltage * supplyVoltage / heaterResistance; // at 100% duty
+};
 
-// DEFAULT_SETTINGS
+// Arduino Uno, USB soldering iron with a 100k 3950 thermistor, the original build
+struct UnoUsbIron : UsbIronDefaults {
+  typedef HeaterPwm<3, 2, 64, 8> Heater; // pin 3, timer 2 at 490Hz, 8 bit
+  typedef NtcThermistor<100000, 4700, 3950, 25, 10, 16> Sensor; // 100k at 25C, 4k7 series, beta 3950, 10 bit ADC
+  static constexpr uint8_t sensorPin = A0;
+  static constexpr uint8_t adcReference = DEFAULT; // thermistor divider fed from 5V
+  static constexpr uint8_t buzzerPin = 5;
+  static constexpr uint8_t encoderA = A1;
+  static constexpr uint8_t encoderB = A2;
+  static constexpr uint8_t encoderButton = A3;
+  static constexpr uint8_t lcdCs = 10; // uses 13, 11 as hardware SPI
+  static constexpr uint8_t lcdA0 = 9;
+  static constexpr uint8_t lcdRst = 8;
+};
 
-#define SETTINGS_STANDBY_TEMP 150 // Celsius
-#define SETTINGS_STANDBY_TIME 60  // seconds
-#define SETTINGS_P 4.5 // proportional
-#define SETTINGS_I 0 // integral
-#define SETTINGS_D 2.0 // derivatinve
-#define SETTINGS_M1 300 // memory M1 
-#define SETTINGS_M2 260 // memory M2
-#define SETTINGS_M3 350 // memory M3
-#define SETTINGS_TEMP_CORRECTION 0.85 //tip's temperature relative to thermistor reading
-#define SETTINGS_MAX_POWER 220 // 0-255 max PWM output power (0-100% in the menu)
-#define SETTINGS_TIMEOUT 30 // minutes before shutoff
-#define SETTINGS_SOUND 1 // 0 to disable , 1 to enable
-#define SETTINGS_RESTORE 1 // restore froms standby 0 MANUAL(by clicking), 1 AUTO (by temperature variation)
+// Arduino Nano, 10k 3950 thermistor read against an external 3.3V AREF, no buzzer,
+// heater on pin 3 at 3.9kHz to keep the PWM out of the audible range of the iron
+struct NanoUsbIron10k : UsbIronDefaults {
+  typedef HeaterPwm<3, 2, 8, 8> Heater; // pin 3, timer 2 at 3.9kHz, 8 bit
+  typedef NtcThermistor<10000, 470, 3950, 25, 10, 16> Sensor;
+  static constexpr uint8_t sensorPin = A0;
+  static constexpr uint8_t adcReference = EXTERNAL;
+  static constexpr uint8_t buzzerPin = NO_PIN;
+  static constexpr uint8_t encoderA = A1;
+  static constexpr uint8_t encoderB = A2;
+  static constexpr uint8_t encoderButton = A3;
+  static constexpr uint8_t lcdCs = 10; // uses 13, 11 as hardware SPI
+  static constexpr uint8_t lcdA0 = 9;
+  static constexpr uint8_t lcdRst = 8;
+  static constexpr double tCorrection = 0.9;
+};
 
+#if defined(BOARD_NANO_USB_IRON_10K)
+typedef NanoUsbIron10k Board;
+#else // BOARD_UNO_USB_IRON
+typedef UnoUsbIron Board;
+#endif
 
+// THERMISTOR TABLE, ADC sums every THERM_TABLE_STEP Celsius from 0, built from Board::Sensor
 
+#define THERM_TABLE_STEP 10  // Celsius
+#define THERM_TABLE_SIZE 51  // 0 to 500 Celsius
 
+#define SERIAL_BAUD 115200
+#define LOGO_TIME 1000 // ms the logo stays on after power up, the heater is already regulating
 
+// TIP PROFILES, every slot starts with the default P, I, D, correction and max power
 
-#endif
\ No newline at end of file
+#define TIP_SLOTS 4 // tip profiles stored in the eeprom
+#define EEPROM_TIPS_ADDRESS 128 // tip profile table, after the settings
+#define EEPROM_ENERGY_ADDRESS 512 // lifetime energy counters, after the tip profiles
+
+// STANDBY LADDER, standby steps down through the stages, then off after the shutoff time
+
+#define STANDBY_DEEP_STAGES 2     // stages after the first standby (deepStandby... in the profile)
+#define REHEAT_MIN_DELTA 20       // Celsius, waking up further below the setpoint heats at max power
+#define REHEAT_LEAD_TIME 0.5      // s, lag of the heater when the tip has no identified time constant
+#define REHEAT_HANDOFF_MARGIN 5   // Celsius, max power stops this far before the predicted arrival
+
+// ADAPTIVE TUNINGS, the PID gains are scaled to keep the loop gain of the identified plant
+
+#define ADAPT_PERIOD 5000     // ms between adaptations
+#define ADAPT_SCALE_MIN 0.5   // the gains never leave 0.5x to 2x the saved tunings
+#define ADAPT_SCALE_MAX 2.0
+#define ADAPT_DEADBAND 0.02   // scale changes below 2% are left alone
+
+// CONTROL LOOP RATE
+// the temperature is sampled and the PID computed fast during transients and slow once settled
+
+#define CONTROL_PERIOD_FAST 25    // ms, heat up, setpoint ramps, tip contact
+#define CONTROL_PERIOD_NORMAL 100 // ms
+#define CONTROL_PERIOD_SLOW 250   // ms, sitting at setpoint
+#define CONTROL_FAST_ERROR 10     // Celsius, error above it goes fast
+#define CONTROL_FAST_SLOPE 5      // Celsius/s, slope above it goes fast
+#define CONTROL_SETTLED_ERROR 2   // Celsius, error below it counts as settled
+#define CONTROL_SETTLED_SLOPE 1   // Celsius/s, slope below it counts as settled
+#define CONTROL_SETTLED_TIME 3000 // ms settled before going slow
+
+#endif
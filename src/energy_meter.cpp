@@ -0,0 +1,109 @@
+#include "energy_meter.h"
+#include <EEPROM.h>
+#include <avr/eeprom.h>
+
+EnergyMeter::EnergyMeter() {
+  memset(&stored, 0, sizeof(stored));
+  memset(&session, 0, sizeof(session));
+  memset(bandMillis, 0, sizeof(bandMillis));
+  memset(bandDutyMillis, 0, sizeof(bandDutyMillis));
+  memset(bandDutyCarry, 0, sizeof(bandDutyCarry));
+  dutyMillis = saturationMillis = runMillis = 0;
+  lastSaveRun = 0;
+  address = 0;
+  pendingSlot = 0;
+  pendingIndex = sizeof(energy_log_t);
+}
+
+uint8_t EnergyMeter::checksum(const energy_log_t &log) {
+  const uint8_t *p = (const uint8_t *)&log;
+  uint8_t sum = 0x5A;
+  for (byte n = 0; n < sizeof(energy_log_t) - 1; n++) {
+    sum = (sum << 1 | sum >> 7) ^ p[n];
+  }
+  return sum;
+}
+
+void EnergyMeter::begin(int eepromAddress) {
+  address = eepromAddress;
+  energy_log_t slot[2];
+  bool valid[2];
+  for (byte n = 0; n < 2; n++) {
+    EEPROM.get(address + n * sizeof(energy_log_t), slot[n]);
+    valid[n] = slot[n].checksum == checksum(slot[n]);
+  }
+  if (valid[0] && (!valid[1] || slot[0].sequence >= slot[1].sequence)) {
+    stored = slot[0];
+    pendingSlot = 1;
+  } else if (valid[1]) {
+    stored = slot[1];
+    pendingSlot = 0;
+  } else {
+    memset(&stored, 0, sizeof(stored)); // blank eeprom, start counting
+    pendingSlot = 0;
+  }
+}
+
+void EnergyMeter::sample(uint8_t duty, bool saturated, double setpoint, uint16_t dtMs) {
+  dutyMillis += (uint32_t)duty * dtMs;
+  while (dutyMillis >= 255000UL) {
+    dutyMillis -= 255000UL;
+    session.fullPowerSeconds++;
+  }
+  runMillis += dtMs;
+  while (runMillis >= 1000) {
+    runMillis -= 1000;
+    session.runSeconds++;
+  }
+  if (saturated) {
+    saturationMillis += dtMs;
+    while (saturationMillis >= 1000) {
+      saturationMillis -= 1000;
+      session.saturationSeconds++;
+    }
+  }
+
+  int band = ((int)setpoint - ENERGY_BAND_START + ENERGY_BAND_WIDTH) / ENERGY_BAND_WIDTH;
+  band = constrain(band, 0, ENERGY_BANDS - 1);
+  bandMillis[band] += dtMs;
+  // the low byte carries to the next sample, dropping it loses most of a low duty at 25 ms
+  uint32_t bandDuty = (uint32_t)duty * dtMs + bandDutyCarry[band];
+  bandDutyMillis[band] += bandDuty >> 8;
+  bandDutyCarry[band] = bandDuty & 0xFF;
+}
+
+void EnergyMeter::service() {
+  if (pendingIndex < sizeof(energy_log_t)) {
+    // one byte per call, and only when the previous write is done
+    if (eeprom_is_ready()) {
+      int slotAddress = address + pendingSlot * sizeof(energy_log_t);
+      EEPROM.update(slotAddress + pendingIndex, ((const uint8_t *)&pending)[pendingIndex]);
+      pendingIndex++;
+      if (pendingIndex == sizeof(energy_log_t)) {
+        pendingSlot ^= 1; // next save goes to the other copy
+      }
+    }
+    return;
+  }
+  if (session.runSeconds - lastSaveRun >= ENERGY_SAVE_PERIOD) {
+    lastSaveRun = session.runSeconds;
+    pending.sequence = stored.sequence + 1;
+    stored.sequence++;
+    pending.fullPowerSeconds = stored.fullPowerSeconds + session.fullPowerSeconds;
+    pending.saturationSeconds = stored.saturationSeconds + session.saturationSeconds;
+    pending.runSeconds = stored.runSeconds + session.runSeconds;
+    pending.checksum = checksum(pending);
+    pendingIndex = 0;
+  }
+}
+
+double EnergyMeter::sessionFullPowerSeconds() { return session.fullPowerSeconds + dutyMillis / 255000.0; }
+
+double EnergyMeter::lifetimeFullPowerSeconds() { return stored.fullPowerSeconds + sessionFullPowerSeconds(); }
+
+double EnergyMeter::bandDuty(byte band) {
+  if (bandMillis[band] == 0) {
+    return 0;
+  }
+  return (bandDutyMillis[band] * 256.0 + bandDutyCarry[band]) / 255.0 / bandMillis[band];
+}
@@ -0,0 +1,59 @@
+#ifndef ENERGY_METER_H
+#define ENERGY_METER_H
+
+#include <Arduino.h>
+
+#define ENERGY_BANDS 5          // setpoint bands: <200, <250, <300, <350, >=350 Celsius
+#define ENERGY_BAND_START 200   // Celsius, upper limit of the first band
+#define ENERGY_BAND_WIDTH 50    // Celsius
+#define ENERGY_SAVE_PERIOD 600  // seconds between lifetime counter saves
+
+// lifetime counters as stored in the eeprom, two copies alternate so a power cut
+// in the middle of a write never loses both
+typedef struct EnergyLog {
+  uint32_t sequence;          // higher is newer
+  uint32_t fullPowerSeconds;  // heater energy in seconds at 100% duty
+  uint32_t saturationSeconds; // time with the output pinned at max power
+  uint32_t runSeconds;        // time with the controller running
+  uint8_t checksum;
+} energy_log_t;
+
+// Integrates the heater PWM duty over time. Energy is counted in full power seconds,
+// multiply by Board::heaterWatts for joules. The eeprom is written one byte per service()
+// call, only when it is ready, so saving never stalls the control loop.
+class EnergyMeter {
+public:
+  EnergyMeter();
+  void begin(int eepromAddress);  // loads the newest valid lifetime counters
+  void sample(uint8_t duty, bool saturated, double setpoint, uint16_t dtMs);
+  void service();                 // call every loop, runs the background eeprom save
+
+  double sessionFullPowerSeconds();
+  double lifetimeFullPowerSeconds();
+  uint32_t sessionSaturationSeconds() { return session.saturationSeconds; }
+  uint32_t lifetimeSaturationSeconds() { return stored.saturationSeconds + session.saturationSeconds; }
+  uint32_t sessionRunSeconds() { return session.runSeconds; }
+  uint32_t lifetimeRunSeconds() { return stored.runSeconds + session.runSeconds; }
+  double bandDuty(byte band);     // average duty 0-1 at the band, session only
+  uint32_t bandSeconds(byte band) { return bandMillis[band] / 1000; }
+
+private:
+  energy_log_t stored;  // lifetime counters at boot
+  energy_log_t session; // counters since boot
+  uint32_t dutyMillis;  // duty * ms not yet carried to fullPowerSeconds, < 255000
+  uint16_t saturationMillis, runMillis; // < 1000, not yet carried to seconds
+  uint32_t bandMillis[ENERGY_BANDS];
+  uint32_t bandDutyMillis[ENERGY_BANDS]; // duty * ms / 256
+  uint8_t bandDutyCarry[ENERGY_BANDS];   // duty * ms % 256 not yet in bandDutyMillis
+  uint32_t lastSaveRun;
+
+  // background save state
+  int address;
+  energy_log_t pending;
+  byte pendingSlot;
+  byte pendingIndex; // next byte of pending to write, sizeof(energy_log_t) when idle
+
+  static uint8_t checksum(const energy_log_t &log);
+};
+
+#endif
@@ -0,0 +1,234 @@
+#include "glyph_font.h"
+
+// large font, 24 rows in 3 pages, seven segment style digits
+#define LARGE_GLYPHS 13
+#define LARGE_PAGES 3
+#define LARGE_SPACING 2
+#define LARGE_SPACE 6 // width of a character the large font lacks
+
+// first column and width of '0'-'9', '.', GLYPH_DEGREE and 'C'
+const uint8_t largeColumn[LARGE_GLYPHS] PROGMEM = {0, 13, 26, 39, 52, 65, 78, 91, 104, 117, 130, 133, 139};
+const uint8_t largeWidth[LARGE_GLYPHS] PROGMEM = {13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 3, 6, 13};
+
+// per glyph: the columns of page 0, then page 1 and 2, bit 0 at the top
+const uint8_t largeGlyphs[] PROGMEM = {
+    // 0
+    0xF8, 0xFC, 0xFA, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xFA, 0xFC, 0xF8,
+    0xE3, 0xF7, 0xE3, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xE3, 0xF7, 0xE3,
+    0x0F, 0x1F, 0x2F, 0x70, 0x70, 0x70, 0x70, 0x70, 0x70, 0x70, 0x2F, 0x1F, 0x0F,
+    // 1
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF8, 0xFC, 0xF8,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xE3, 0xF7, 0xE3,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0x1F, 0x0F,
+    // 2
+    0x00, 0x00, 0x02, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xFA, 0xFC, 0xF8,
+    0xE0, 0xF0, 0xE8, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x0B, 0x07, 0x03,
+    0x0F, 0x1F, 0x2F, 0x70, 0x70, 0x70, 0x70, 0x70, 0x70, 0x70, 0x20, 0x00, 0x00,
+    // 3
+    0x00, 0x00, 0x02, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xFA, 0xFC, 0xF8,
+    0x00, 0x00, 0x08, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0xEB, 0xF7, 0xE3,
+    0x00, 0x00, 0x20, 0x70, 0x70, 0x70, 0x70, 0x70, 0x70, 0x70, 0x2F, 0x1F, 0x0F,
+    // 4
+    0xF8, 0xFC, 0xF8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF8, 0xFC, 0xF8,
+    0x03, 0x07, 0x0B, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0xEB, 0xF7, 0xE3,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0x1F, 0x0F,
+    // 5
+    0xF8, 0xFC, 0xFA, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x02, 0x00, 0x00,
+    0x03, 0x07, 0x0B, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0xE8, 0xF0, 0xE0,
+    0x00, 0x00, 0x20, 0x70, 0x70, 0x70, 0x70, 0x70, 0x70, 0x70, 0x2F, 0x1F, 0x0F,
+    // 6
+    0xF8, 0xFC, 0xFA, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x02, 0x00, 0x00,
+    0xE3, 0xF7, 0xEB, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0xE8, 0xF0, 0xE0,
+    0x0F, 0x1F, 0x2F, 0x70, 0x70, 0x70, 0x70, 0x70, 0x70, 0x70, 0x2F, 0x1F, 0x0F,
+    // 7
+    0x00, 0x00, 0x02, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xFA, 0xFC, 0xF8,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xE3, 0xF7, 0xE3,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0x1F, 0x0F,
+    // 8
+    0xF8, 0xFC, 0xFA, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xFA, 0xFC, 0xF8,
+    0xE3, 0xF7, 0xEB, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0xEB, 0xF7, 0xE3,
+    0x0F, 0x1F, 0x2F, 0x70, 0x70, 0x70, 0x70, 0x70, 0x70, 0x70, 0x2F, 0x1F, 0x0F,
+    // 9
+    0xF8, 0xFC, 0xFA, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0xFA, 0xFC, 0xF8,
+    0x03, 0x07, 0x0B, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0xEB, 0xF7, 0xE3,
+    0x00, 0x00, 0x20, 0x70, 0x70, 0x70, 0x70, 0x70, 0x70, 0x70, 0x2F, 0x1F, 0x0F,
+    // .
+    0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00,
+    0x70, 0x70, 0x70,
+    // deg
+    0x1E, 0x33, 0x21, 0x21, 0x33, 0x1E,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    // C
+    0xF8, 0xFC, 0xFA, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x02, 0x00, 0x00,
+    0xE3, 0xF7, 0xE3, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x0F, 0x1F, 0x2F, 0x70, 0x70, 0x70, 0x70, 0x70, 0x70, 0x70, 0x20, 0x00, 0x00,
+};
+
+// small font, 5x7 in one page, ' ' to 'Z'
+#define SMALL_FIRST ' '
+#define SMALL_LAST 'Z'
+#define SMALL_WIDTH 5
+#define SMALL_SPACING 1
+
+const uint8_t smallGlyphs[(SMALL_LAST - SMALL_FIRST + 1) * SMALL_WIDTH] PROGMEM = {
+    0x00, 0x00, 0x00, 0x00, 0x00, // space
+    0x00, 0x00, 0x5F, 0x00, 0x00, // !
+    0x00, 0x07, 0x00, 0x07, 0x00, // "
+    0x14, 0x7F, 0x14, 0x7F, 0x14, // #
+    0x24, 0x2A, 0x7F, 0x2A, 0x12, // $
+    0x23, 0x13, 0x08, 0x64, 0x62, // %
+    0x36, 0x49, 0x55, 0x22, 0x50, // &
+    0x00, 0x05, 0x03, 0x00, 0x00, // '
+    0x00, 0x1C, 0x22, 0x41, 0x00, // (
+    0x00, 0x41, 0x22, 0x1C, 0x00, // )
+    0x08, 0x2A, 0x1C, 0x2A, 0x08, // *
+    0x08, 0x08, 0x3E, 0x08, 0x08, // +
+    0x00, 0x50, 0x30, 0x00, 0x00, // ,
+    0x08, 0x08, 0x08, 0x08, 0x08, // -
+    0x00, 0x60, 0x60, 0x00, 0x00, // .
+    0x20, 0x10, 0x08, 0x04, 0x02, // /
+    0x3E, 0x51, 0x49, 0x45, 0x3E, // 0
+    0x00, 0x42, 0x7F, 0x40, 0x00, // 1
+    0x42, 0x61, 0x51, 0x49, 0x46, // 2
+    0x21, 0x41, 0x45, 0x4B, 0x31, // 3
+    0x18, 0x14, 0x12, 0x7F, 0x10, // 4
+    0x27, 0x45, 0x45, 0x45, 0x39, // 5
+    0x3C, 0x4A, 0x49, 0x49, 0x30, // 6
+    0x01, 0x71, 0x09, 0x05, 0x03, // 7
+    0x36, 0x49, 0x49, 0x49, 0x36, // 8
+    0x06, 0x49, 0x49, 0x29, 0x1E, // 9
+    0x00, 0x36, 0x36, 0x00, 0x00, // :
+    0x00, 0x56, 0x36, 0x00, 0x00, // ;
+    0x00, 0x08, 0x14, 0x22, 0x41, // <
+    0x14, 0x14, 0x14, 0x14, 0x14, // =
+    0x41, 0x22, 0x14, 0x08, 0x00, // >
+    0x02, 0x01, 0x51, 0x09, 0x06, // ?
+    0x32, 0x49, 0x79, 0x41, 0x3E, // @
+    0x7E, 0x11, 0x11, 0x11, 0x7E, // A
+    0x7F, 0x49, 0x49, 0x49, 0x36, // B
+    0x3E, 0x41, 0x41, 0x41, 0x22, // C
+    0x7F, 0x41, 0x41, 0x22, 0x1C, // D
+    0x7F, 0x49, 0x49, 0x49, 0x41, // E
+    0x7F, 0x09, 0x09, 0x01, 0x01, // F
+    0x3E, 0x41, 0x41, 0x51, 0x32, // G
+    0x7F, 0x08, 0x08, 0x08, 0x7F, // H
+    0x00, 0x41, 0x7F, 0x41, 0x00, // I
+    0x20, 0x40, 0x41, 0x3F, 0x01, // J
+    0x7F, 0x08, 0x14, 0x22, 0x41, // K
+    0x7F, 0x40, 0x40, 0x40, 0x40, // L
+    0x7F, 0x02, 0x04, 0x02, 0x7F, // M
+    0x7F, 0x04, 0x08, 0x10, 0x7F, // N
+    0x3E, 0x41, 0x41, 0x41, 0x3E, // O
+    0x7F, 0x09, 0x09, 0x09, 0x06, // P
+    0x3E, 0x41, 0x51, 0x21, 0x5E, // Q
+    0x7F, 0x09, 0x19, 0x29, 0x46, // R
+    0x46, 0x49, 0x49, 0x49, 0x31, // S
+    0x01, 0x01, 0x7F, 0x01, 0x01, // T
+    0x3F, 0x40, 0x40, 0x40, 0x3F, // U
+    0x1F, 0x20, 0x40, 0x20, 0x1F, // V
+    0x7F, 0x20, 0x18, 0x20, 0x7F, // W
+    0x63, 0x14, 0x08, 0x14, 0x63, // X
+    0x03, 0x04, 0x78, 0x04, 0x03, // Y
+    0x61, 0x51, 0x49, 0x45, 0x43, // Z
+};
+
+typedef char (*TextReader)(const char *);
+
+static char readRam(const char *text) { return *text; }
+
+static char readFlash(const char *text) { return pgm_read_byte(text); }
+
+// index in the large font, LARGE_GLYPHS when it has no such glyph
+static uint8_t largeIndex(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  return (c == '.') ? 10 : (c == GLYPH_DEGREE) ? 11 : (c == 'C') ? 12 : LARGE_GLYPHS;
+}
+
+// anything the small font lacks is a space
+static char smallChar(char c) {
+  if (c >= 'a' && c <= 'z') {
+    c -= 'a' - 'A';
+  }
+  return (c >= SMALL_FIRST && c <= SMALL_LAST) ? c : ' ';
+}
+
+static uint8_t textWidth(const char *text, uint8_t font, TextReader read) {
+  uint8_t width = 0;
+  uint8_t spacing = (font == FONT_LARGE) ? LARGE_SPACING : SMALL_SPACING;
+  for (char c = read(text); c != '\0'; c = read(++text)) {
+    if (font == FONT_LARGE) {
+      uint8_t index = largeIndex(c);
+      width += (index < LARGE_GLYPHS) ? pgm_read_byte(&largeWidth[index]) : LARGE_SPACE;
+    } else {
+      width += SMALL_WIDTH;
+    }
+    width += spacing;
+  }
+  return (width > 0) ? width - spacing : 0;
+}
+
+static void drawText(U8GLIB &u8g, uint8_t x, uint8_t y, const char *text, uint8_t font, uint8_t color,
+                     TextReader read) {
+  u8g_pb_t *pb = (u8g_pb_t *)u8g.getU8g()->dev->dev_mem;
+  uint8_t pages = (font == FONT_LARGE) ? LARGE_PAGES : 1;
+  // glyph pages overlapping the page being rendered, at most two, and how far to shift them
+  int8_t shift[2];
+  uint8_t glyphPage[2];
+  uint8_t overlaps = 0;
+  for (uint8_t page = 0; page < pages; page++) {
+    int16_t delta = (int16_t)pb->p.page_y0 - y - 8 * page;
+    if (delta > -8 && delta < 8) {
+      glyphPage[overlaps] = page;
+      shift[overlaps++] = delta;
+    }
+  }
+  if (overlaps == 0) {
+    return; // nothing of the text in this page
+  }
+  uint8_t *buffer = (uint8_t *)pb->buf;
+  for (char c = read(text); c != '\0'; c = read(++text)) {
+    const uint8_t *glyph;
+    uint8_t width;
+    if (font == FONT_LARGE) {
+      uint8_t index = largeIndex(c);
+      if (index >= LARGE_GLYPHS) {
+        x += LARGE_SPACE + LARGE_SPACING;
+        continue;
+      }
+      width = pgm_read_byte(&largeWidth[index]);
+      glyph = largeGlyphs + LARGE_PAGES * pgm_read_byte(&largeColumn[index]);
+    } else {
+      width = SMALL_WIDTH;
+      glyph = smallGlyphs + SMALL_WIDTH * (smallChar(c) - SMALL_FIRST);
+    }
+    for (uint8_t column = 0; column < width && x < pb->width; column++, x++) {
+      uint8_t bits = 0;
+      for (uint8_t n = 0; n < overlaps; n++) {
+        uint8_t b = pgm_read_byte(glyph + glyphPage[n] * width + column);
+        bits |= (shift[n] >= 0) ? b >> shift[n] : b << -shift[n];
+      }
+      if (color) {
+        buffer[x] |= bits;
+      } else {
+        buffer[x] &= ~bits;
+      }
+    }
+    x += (font == FONT_LARGE) ? LARGE_SPACING : SMALL_SPACING;
+  }
+}
+
+void drawGlyphs(U8GLIB &u8g, uint8_t x, uint8_t y, const char *text, uint8_t font, uint8_t color) {
+  drawText(u8g, x, y, text, font, color, readRam);
+}
+
+void drawGlyphsP(U8GLIB &u8g, uint8_t x, uint8_t y, const char *text, uint8_t font, uint8_t color) {
+  drawText(u8g, x, y, text, font, color, readFlash);
+}
+
+uint8_t glyphsWidth(const char *text, uint8_t font) { return textWidth(text, font, readRam); }
+
+uint8_t glyphsWidthP(const char *text, uint8_t font) { return textWidth(text, font, readFlash); }
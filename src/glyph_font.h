@@ -0,0 +1,23 @@
+#ifndef GLYPH_FONT_H
+#define GLYPH_FONT_H
+
+#include <Arduino.h>
+#include <U8glib.h>
+
+#define GLYPH_DEGREE '\x7F'     // degree sign in the large font
+#define GLYPH_DEGREE_STRING "\x7F"
+
+enum GLYPH_FONT { FONT_SMALL, FONT_LARGE };
+
+// Fonts for what the screens show and nothing more: large digits with '.', the degree sign
+// and 'C', and 5x7 uppercase text (lowercase prints in uppercase). The glyphs are stored in
+// PCD8544 order, a byte is 8 rows of a column with bit 0 on top, which is also the layout of
+// the U8glib page buffer. Drawing copies the glyph bytes that fall in the page being rendered,
+// shifted when y is not a multiple of 8. Call from the picture loop, y is the top row, color
+// 1 sets the pixels and 0 clears them.
+void drawGlyphs(U8GLIB &u8g, uint8_t x, uint8_t y, const char *text, uint8_t font, uint8_t color);
+void drawGlyphsP(U8GLIB &u8g, uint8_t x, uint8_t y, const char *text, uint8_t font, uint8_t color); // text in flash
+uint8_t glyphsWidth(const char *text, uint8_t font);
+uint8_t glyphsWidthP(const char *text, uint8_t font); // text in flash
+
+#endif
@@ -1,20 +1,45 @@
 #include <Arduino.h>
-#include "SmoothThermistor.h"
 #include <PID_v1.h>
 #include <EEPROM.h>
+#include <avr/eeprom.h>
 #include <ClickEncoder.h>
 #include <TimerOne.h>
 #include <U8glib.h>
 #include "avr/wdt.h"
 #include "bitmap_logo.h"
 #include "config.h"
+#include "thermistor.h"
+#include "thermal_observer.h"
+#include "setpoint_shaper.h"
+#include "settings_frame.h"
+#include "energy_meter.h"
+#include "plant_identifier.h"
+#include "bench.h"
+#include "glyph_font.h"
 
 
 enum VIEW { VIEW_LOGO, VIEW_MAIN, VIEW_SETTINGS } view;
 enum MEM { MEM1, MEM2, MEM3 } mem;
-
-const char *title[] = {"EXIT",   "STDBY TIME", "STDBY TEMP", "RESTORE",   "POWER OFF", "SOUNDS",   "PID: P",
-                       "PID: I", "PID: D",     "TEMP CORR",  "MAX POWER", "SAVE ALL",  "RESET ALL"};
+#define MEM_TIP_FIRST (MEM3 + 1) // in the store mode selector the tip profiles follow the memories
+
+// menu titles live in flash, read them back with pgm_read_ptr()
+const char title0[] PROGMEM = "EXIT";
+const char title1[] PROGMEM = "STDBY TIME";
+const char title2[] PROGMEM = "STDBY TEMP";
+const char title3[] PROGMEM = "RESTORE";
+const char title4[] PROGMEM = "POWER OFF";
+const char title5[] PROGMEM = "SOUNDS";
+const char title6[] PROGMEM = "PID: P";
+const char title7[] PROGMEM = "PID: I";
+const char title8[] PROGMEM = "PID: D";
+const char title9[] PROGMEM = "TEMP CORR";
+const char title10[] PROGMEM = "MAX POWER";
+const char title11[] PROGMEM = "RAMP RATE";
+const char title12[] PROGMEM = "RAMP TYPE";
+const char title13[] PROGMEM = "SAVE ALL";
+const char title14[] PROGMEM = "RESET ALL";
+const char *const title[] PROGMEM = {title0,  title1,  title2,  title3,  title4,  title5,  title6, title7,
+                                     title8,  title9,  title10, title11, title12, title13, title14};
 enum MENU {
   // it should match title array, this way it's easier to add more menus later
   MENU_EXIT = 0,
@@ -28,6 +53,8 @@ enum MENU {
   MENU_D,
   MENU_T_CORR,
   MENU_MAX_PWR,
+  MENU_RAMP_RATE,
+  MENU_RAMP_TYPE,
   MENU_SAVE_ALL,
   MENU_RESET_ALL,
   MENU_LENGHT // easy way having the menu lenght
@@ -35,29 +62,80 @@ enum MENU {
 byte menuPosition;
 
 byte memoryToStore;
-ClickEncoder *encoder;
+ClickEncoder encoder(Board::encoderA, Board::encoderB, Board::encoderButton); // A, B, BTN
 int16_t encLast, encValue;
 
-double Setpoint, Input, Output, serialMillis, lcdMillis, logoMillis, blinkMillis, functionTimeout, standByMillis,
-    tempBeforeEnteringStandby;
+double Setpoint, Input, Output, tempBeforeEnteringStandby;
+double pidSetpoint; // Setpoint shaped into a ramp, the one the PID follows
+SetpointShaper shaper;
+// timestamps: 16 bit for the short periodic tasks (wrap safe below 65s), 32 bit for the long ones
+uint16_t serialMillis, lcdMillis, logoMillis;
+uint32_t functionTimeout, standByMillis; // standByMillis: last activity or when the standby stage began
 bool isDisplayingLogo, blink, isSavingMemory, isOnStandBy, isPlotting;
 
 // measuring the temp variation per second
 double tempVariation;
 double oldTemp;
-double tempMillis;
+uint16_t tempMillis;
 bool beepAtSetpoint;
 
+// setpoint transition statistics
+uint32_t transitionMillis; // when Setpoint last changed
+uint32_t timeToSetpoint;   // ms until Input got within TRANSITION_BAND, 0 while not there
+double transitionTarget;
+double overshoot; // worst Input excursion past the target since the change
+bool isTransitionUp;
+#define TRANSITION_BAND 2 // Celsius
+
+// adaptive control rate
+uint16_t controlPeriod;    // ms between temperature samples and PID computes
+uint16_t controlMillis;    // when the PID last computed, the next sample is scheduled from it
+uint16_t sampleMillis;     // when the last sample started
+uint16_t controlDt;        // ms since the previous sample, measured, what the integrators use
+uint16_t settledMillis;    // how long the loop has been settled
+double lastInput;
+double inputSlope;         // filtered Celsius/s
+uint32_t controlMicros;    // time spent sampling and computing since statsMillis
+uint32_t controlSamples;   // samples since statsMillis
+uint32_t statsMillis;
+
+// boot
+enum BOOT { BOOT_LOGO, BOOT_BANNER, BOOT_TUNINGS, BOOT_DEFAULTS, BOOT_BEEP, BOOT_DONE } bootStage;
+bool isSavingDefaults;     // eeprom was blank or outdated, defaults are saved after heating started
+uint16_t defaultsIndex;    // next byte of the defaults to save, one per loop pass
+uint32_t firstPwmMicros;   // time from power up to the first heater pwm write
+uint32_t bootReadyMillis;  // time from power up to Input near Setpoint, 0 until then
+
+EnergyMeter energy;
+
 // settings menu vars;
 bool isEditing;
-const char *topText;
-const char *bottomText;
 bool isFastCount;
-int i;
-double d;
+
+// serial command line buffer
+#define SERIAL_BUFFER_SIZE 16
+char serialBuffer[SERIAL_BUFFER_SIZE];
+
+// stack painting, see paintStack()
+#define STACK_CANARY 0xC5
+extern uint8_t _end;
+extern uint8_t __stack;
+extern uint8_t __data_start;
+extern uint8_t __heap_start;
+extern void *__brkval;
+
+#define EEPROM_CHECK 128 // change it whenever eeprom_map_t or tip_profile_t changes, forces the defaults
+
+typedef struct StandbyStage {
+  uint16_t time; // seconds in the previous stage before this one, 0 ends the ladder
+  uint16_t temp; // Celsius
+} standby_stage_t;
+
+#define STANDBY_STAGES (STANDBY_DEEP_STAGES + 1) // the first stage is standbyTime/standbyTemp
+#define STANDBY_OFF 0xFF                          // standbyStage after the shutoff time
 
 typedef struct EepromMap {
-  byte firstBoot;     // check for a number 123
+  byte firstBoot;     // check for EEPROM_CHECK
   double standbyTemp; // temperature on stand-by
   unsigned int standbyTime;
   double p;           // p
@@ -72,16 +150,88 @@ typedef struct EepromMap {
   byte lastMem;         // lastMemory selected
   bool sound;           // sound on /off
   bool restore;         // 0 manual 1 auto
+  byte rampRate;        // max setpoint slope Celsius/s, 0 no ramp
+  byte rampProfile;     // RAMP_STEP, RAMP_LINEAR or RAMP_SCURVE
+  byte activeTip;       // tip profile slot p, i, d, tCorrection and maxPower came from
+  standby_stage_t ladder[STANDBY_DEEP_STAGES]; // standby stages after the first one
+  bool adaptive;        // PID gains follow the identified plant
 
 } eeprom_map_t;
 
 eeprom_map_t settings;
 
+#define TIP_NAME_SIZE 6 // 5 characters
 
-U8GLIB_PCD8544 u8g(LCD_CS,LCD_A0, LCD_RST); // uses 13 ,11 as Hardware pins 10-CS 9-A0 8-RS
+typedef struct TipProfile {
+  char name[TIP_NAME_SIZE];
+  double p;           // p
+  double i;           // i
+  double d;           // d
+  double tCorrection; // thermistor reading temperature correction factor
+  byte maxPower;
+  double tauHeater;   // identified heater time constant in seconds, 0 unknown
+  double tauTip;      // identified tip time constant in seconds, 0 unknown
+  double heaterGain;  // Celsius the heater runs above the tip at full duty, 0 unknown
+  double tipLoss;     // tip to ambient loss ratio, 0 unknown
+  double refGain;     // identified plant gain when the tunings were good, 0 none
+  double refTau;      // identified plant time constant then, seconds
+} tip_profile_t;
+
+typedef struct TipFrame { // payload of a FRAME_TIP frame
+  byte slot;
+  tip_profile_t tip;
+} tip_frame_t;
+
+static_assert(sizeof(eeprom_map_t) <= EEPROM_TIPS_ADDRESS, "settings overlap the tip profiles");
+static_assert(EEPROM_TIPS_ADDRESS + TIP_SLOTS * sizeof(tip_profile_t) <= EEPROM_ENERGY_ADDRESS,
+              "tip profiles overlap the energy counters");
+
+// frame being received, decoded as it arrives over as many loop passes as it takes
+#define FRAME_PAYLOAD_SIZE (sizeof(eeprom_map_t) > sizeof(tip_frame_t) ? sizeof(eeprom_map_t) : sizeof(tip_frame_t))
+#define FRAME_BUFFER_SIZE (FRAME_HEADER_SIZE + FRAME_PAYLOAD_SIZE + 2) // header, payload, crc
+#define FRAME_TIMEOUT 1000 // ms without a character, the rest of a truncated frame never comes
+uint8_t frameBuffer[FRAME_BUFFER_SIZE];
+byte frameDigits;        // hex digits received
+bool isReceivingFrame;   // FRAME_START seen, waiting for the newline
+bool isFrameComplete;    // newline received, the frame waits for the serial stage
+bool isFrameBad;         // a character that is not hex or more than fits
+uint16_t frameMillis;    // last character received
+tip_profile_t stagedTips[TIP_SLOTS]; // tip frames of a clone, committed by its settings frame
+byte stagedTipMask;      // bit per slot staged
+
+static_assert(FRAME_BUFFER_SIZE * 2 <= 0xFF, "hex digits of a frame must fit frameDigits");
+
+char activeTipName[TIP_NAME_SIZE];
+double tauHeater, tauTip, heaterGain, tipLoss; // thermal model of the active tip
+double sensorTemp; // heater temperature as read by the thermistor
+bool isFaulted;    // the over temperature cutoff tripped, latched until a reboot or reset
+ThermalObserver observer;
+bool isLoggingObserver;
+
+// standby ladder
+byte standbyStage;      // 0 working, 1 to STANDBY_STAGES, STANDBY_OFF
+uint32_t idleMillis;    // last activity, for the shutoff
+bool isReheating;       // waking up at max power, the PID takes over near the setpoint
+bool isWaking;          // measuring time-to-ready
+byte wakeStage;         // stage the iron was woken from, index of the statistics below
+uint32_t wakeMillis;
+uint32_t readyLast[STANDBY_STAGES + 1];  // ms to get back to the setpoint from each stage, last is off
+uint32_t readyTotal[STANDBY_STAGES + 1];
+uint16_t readyCount[STANDBY_STAGES + 1];
+
+// online plant identification
+PlantIdentifier identifier;
+double refGain, refTau;     // active tip plant the tunings were made for
+double adaptScale = 1;      // applied P and D over the base tunings
+double adaptIntegralScale = 1; // applied I over the base tuning
+uint16_t adaptMillis;
+
+
+U8GLIB_PCD8544 u8g(Board::lcdCs, Board::lcdA0, Board::lcdRst); // uses 13 ,11 as Hardware pins
 
 // void setPwmFrequency(int, int); // sets pwm frequency divisor
 double getTemp();             // read thermistor temp
+void configureObserver();     // applies the active tip thermal model to the observer
 void resetFailSafe();         // reset all eeprom to default
 void printTunnings();         // outputs de pid settings
 void draw();                  // displays a view
@@ -96,64 +246,89 @@ void cicleMem();              // cicle ...MEM1->MEM2->MEM3->MEM1...
 void resetTimeouts();         // reset    all timouts running to millis()
 void drawMemIcon(byte);       // draws the given memory icon
 void resetStandby();          // reset standby time count down
+void updateStandby();         // steps down the standby ladder
+void enterStandby(byte);      // goes to a standby stage or STANDBY_OFF
+uint16_t stageTime(byte);     // seconds before a standby stage
+uint16_t stageTemp(byte);     // setpoint of a standby stage
+void reheat();                // max power part of the wake up
+void printStandby();          // outputs the ladder and the time-to-ready from each stage
+void adaptTunings();          // scales the PID gains to the identified plant
+void setAdaptScale(double, double); // applies new scales to the running tunings
+void printPlant();            // outputs the identified plant and the adaptation
 void rotarySettings();        // process rotary on the settings view
-void drawTitle(const char *); // draws the title inverse bar on the settings menu
+void drawTitle(const char *); // draws the title (flash string) inverse bar on the settings menu
+bool hasSound();              // buzzer fitted and sounds enabled
 void beep();                  // sound 
 void beepBeep();
 void beepBop();
 void bop();
 void bopLong();
-
-SmoothThermistor therm(SENSOR_PIN,      // the analog pin to read from
-                       ADC_SIZE_10_BIT, // the ADC size
-                       100000,          // the nominal resistance
-                       4700,            // the series resistance
-                       3950,            // the beta coefficient of the thermistor
-                       25,              // the temperature for nominal resistance
-                       10);             // the number of samples to take for each measurement
-
-PID myPID(&Input, &Output, &Setpoint, 0, 0, 0, DIRECT);
+uint16_t millis16();          // lower 16 bits of millis() for short timeouts
+bool isCommand(const char *); // compares the serial command with a flash string
+uint16_t freeRam();           // bytes between heap top and stack pointer
+uint16_t stackHighWater();    // bytes of stack ever used since boot
+void printMemory();           // outputs the ram usage report
+void configureShaper();       // applies the ramp settings to the setpoint shaper
+void trackTransition();       // measures time-to-setpoint and overshoot
+void printTransition();       // outputs the last transition statistics
+void controlTemperature();    // samples the temperature and runs the PID
+void updateControlRate();     // picks the control period from error and slope
+void setControlPeriod(uint16_t); // changes the sample period, PID gains rescale with it
+void printControlRate();      // outputs the control rate and cpu usage
+void printEnergy();           // outputs the heater energy and duty statistics
+void saveSettings();          // saves the settings and the active tip profile
+int tipAddress(byte);         // eeprom address of a tip profile slot
+bool selectTip(byte);         // loads a tip profile and applies it
+void saveTip(byte);           // stores the active tunings in a tip profile slot
+void resetTips();             // every tip profile slot to defaults
+void defaultTip(byte, tip_profile_t &); // default profile of a slot, tunings from the settings
+bool saveDefaultsByte();      // saves the next byte of the defaults, true when all are saved
+void readTipName(byte, char *); // copies a slot name from the eeprom
+void printTips();             // lists the tip profiles
+void loadTipModel(byte);      // loads a slot name and time constants, not the tunings
+void applyTipModel(const tip_profile_t &); // makes a profile name and time constants the active ones
+bool isValidTip(const tip_profile_t &); // range check of a tip profile
+void loadDefaults();          // default settings in ram, nothing saved
+void serviceBoot();           // runs the next boot step that isn't needed for heating
+void printBoot();             // outputs the boot timings
+void applySettings();         // applies the settings to the running controller
+bool isValidSettings(const eeprom_map_t &); // range check of a settings snapshot
+bool isValidLadder(const eeprom_map_t &);
+void sendFrame(uint8_t, const void *, uint8_t); // outputs one frame with the given flags and payload
+void sendSettingsFrame();     // outputs the tip profiles and the settings, one frame each
+void receiveSettingsFrame();  // checks a complete frame, stages a tip frame or applies the settings
+void writeHexByte(uint8_t);
+void collectFrame();          // moves the frame characters received so far into frameBuffer
+
+PID myPID(&Input, &Output, &pidSetpoint, 0, 0, 0, DIRECT);
 
 void setup() {
-  Serial.begin(9600);
-  Serial.println(F("* START *"));
-
-  tempVariation = 0;
-  oldTemp = getTemp();
-  // input and output pins
-  pinMode(SENSOR_PIN, INPUT);
-  pinMode(HEATER_PIN, OUTPUT);
-  pinMode(BUZZER_PIN, OUTPUT);
-
-  // rotary encoder
-  encoder = new ClickEncoder(A1, A2, A3); // A, B, BTN
-  encoder->setAccelerationEnabled(true);
-  Timer1.initialize(1000);
-  Timer1.attachInterrupt(timerIsr);
-  // encLast = -1;
-  encLast = encValue = encoder->getValue();
-
-  // LCD
-  u8g.setColorIndex(1);
-  view = VIEW_LOGO; // display logo view.
-  updateLCD();
-  isDisplayingLogo = true;
-
-  // heater
-  // setPwmFrequency(HEATER_PIN, 1);
-  analogWrite(HEATER_PIN, 0); // set heater to 0
-
-  lcdMillis = serialMillis = logoMillis = blinkMillis = standByMillis = millis(); // delay routines
+  // heater first, it must never float while the rest boots
+  pinMode(Board::Heater::pin, OUTPUT);
+  analogWrite(Board::Heater::pin, 0); // set heater to 0
+  if (Board::Heater::timer == 2) {     // heater pwm frequency
+    TCCR2B = (TCCR2B & 0xF8) | Board::Heater::clockSelect;
+  }
+  pinMode(Board::sensorPin, INPUT);
+  analogReference(Board::adcReference);
+  if (Board::buzzerPin != NO_PIN) {
+    pinMode(Board::buzzerPin, OUTPUT);
+  }
+  Serial.begin(SERIAL_BAUD); // only sets registers, the banner goes out from loop()
 
-  // Load EEPROM
+  // Load EEPROM, before any reading since getTemp() needs tCorrection
   EEPROM.get(0, settings);
-  if (settings.firstBoot != 123) { // if the check number is not present then save settings
-    resetFailSafe();
+  if (settings.firstBoot != EEPROM_CHECK || !isValidSettings(settings)) { // use defaults, saved from loop()
+    loadDefaults();
+    isSavingDefaults = true;
+  } else if (!selectTip(settings.activeTip)) {
+    applySettings();
   }
-  myPID.SetTunings(settings.p, settings.i, settings.d);
-  printTunnings();
 
-  Input = getTemp();
+  Input = oldTemp = getTemp();
+  sensorTemp = readThermistor();
+  configureObserver();
+  tempVariation = 0;
   //  choose last selected memory setpoint temperature
   switch (settings.lastMem) {
   case MEM1:
@@ -169,13 +344,38 @@ void setup() {
     Setpoint = 150;
   }
   tempBeforeEnteringStandby = Setpoint;
-
-  myPID.SetMode(AUTOMATIC);                    // enable pid controller
+  // ramp up from the actual tip temperature
+  configureShaper();
+  shaper.reset(Input);
+  pidSetpoint = lastInput = Input;
+  inputSlope = 0;
+  controlPeriod = CONTROL_PERIOD_FAST;
+  myPID.SetSampleTime(controlPeriod);
   myPID.SetOutputLimits(0, settings.maxPower); // limits heater pwm duty cycle
+  myPID.SetMode(AUTOMATIC);                    // enable pid controller
+  sampleMillis = millis16() - controlPeriod;
+  controlTemperature();                        // heating starts here
+  settledMillis = millis16();
+  statsMillis = millis();
 
-  u8g.setColorIndex(0);
-  u8g.drawBox(0, 0, 84, 48);
+  // rotary encoder
+  encoder.setAccelerationEnabled(true);
+  Timer1.initialize(1000);
+  Timer1.attachInterrupt(timerIsr);
+  // encLast = -1;
+  encLast = encValue = encoder.getValue();
+
+  energy.begin(EEPROM_ENERGY_ADDRESS);
+
+  // LCD, the logo is drawn from loop() with the rest of the boot work
   u8g.setColorIndex(1);
+  view = VIEW_LOGO; // display logo view.
+  isDisplayingLogo = true;
+  bootStage = BOOT_LOGO;
+
+  lcdMillis = serialMillis = logoMillis = tempMillis = millis16(); // delay routines
+  standByMillis = idleMillis = millis();
+
   blink = false;
   isSavingMemory = false;
   memoryToStore = settings.lastMem;
@@ -185,59 +385,183 @@ void setup() {
   isFastCount = false;
   isPlotting = false;
   beepAtSetpoint = true;
-  beep();
 }
 
 void loop() {
+  BENCH_MARK(BENCH_SERIAL);
   // serial input control
-  if (Serial.available() > 0) {
-    String strInput = Serial.readString();
-    String command = strInput.substring(0, 2);
-    double value = strInput.substring(2, strInput.length()).toDouble();
-    if (command == "p:") {
+  if (!isReceivingFrame && Serial.available() > 0 && Serial.peek() == FRAME_START) {
+    Serial.read();
+    isReceivingFrame = true;
+    isFrameComplete = isFrameBad = false;
+    frameDigits = 0;
+    frameMillis = millis16();
+  }
+  if (isReceivingFrame) { // never waits for the rest, control runs while a frame comes in
+    collectFrame();
+    if (isFrameComplete) {
+      isReceivingFrame = false;
+      receiveSettingsFrame();
+    } else if ((uint16_t)(millis16() - frameMillis) > FRAME_TIMEOUT) {
+      isReceivingFrame = false;
+      Serial.println(F("#ERR bad frame"));
+    }
+  } else if (Serial.available() > 0) {
+    byte len = Serial.readBytesUntil('\n', serialBuffer, SERIAL_BUFFER_SIZE - 1);
+    while (len > 0 && (serialBuffer[len - 1] == '\r' || serialBuffer[len - 1] == ' ')) {
+      len--;
+    }
+    serialBuffer[len] = '\0';
+    char *separator = strchr(serialBuffer, ':');
+    double value = (separator != NULL) ? atof(separator + 1) : 0;
+    if (isCommand(PSTR("p:"))) {
       Serial.print(F("changed P value to: "));
       myPID.SetTunings(value, myPID.GetKi(), myPID.GetKd());
       Serial.println(myPID.GetKp());
-    } else if (command == "i:") {
+    } else if (isCommand(PSTR("i:"))) {
       Serial.print(F("changed I value to: "));
       myPID.SetTunings(myPID.GetKp(), value, myPID.GetKd());
       Serial.println(myPID.GetKi());
-    } else if (command == "d:") {
+    } else if (isCommand(PSTR("d:"))) {
       Serial.print(F("changed D value to: "));
       myPID.SetTunings(myPID.GetKp(), myPID.GetKi(), value);
       Serial.println(myPID.GetKd());
-    } else if (command == "t") {
+    } else if (isCommand(PSTR("t"))) {
       printTunnings();
-    } else if (command == "t:") {
+    } else if (isCommand(PSTR("t:"))) {
       Serial.print(F("Setpoint: "));
       Setpoint = value;
       Serial.println(Setpoint);
-    } else if (command == "s") {
+    } else if (isCommand(PSTR("s"))) {
       // save settings
-      settings.p = myPID.GetKp();
-      settings.i = myPID.GetKi();
-      settings.d = myPID.GetKd();
-      EEPROM.put(0, settings);
+      settings.p = myPID.GetKp() / adaptScale; // the base tunings, not the adapted ones
+      settings.i = myPID.GetKi() / adaptIntegralScale;
+      settings.d = myPID.GetKd() / adaptScale;
+      saveSettings();
       Serial.println(F("Settings saved!"));
-    } else if (command == "r") {
+    } else if (isCommand(PSTR("r"))) {
       resetFailSafe();
-    } else if (command == "pl") {
+    } else if (isCommand(PSTR("pl"))) {
       isPlotting = !isPlotting;
+    } else if (isCommand(PSTR("m"))) {
+      printMemory();
+    } else if (isCommand(PSTR("rr:"))) {
+      settings.rampRate = constrain(value, 0, 100);
+      configureShaper();
+      Serial.print(F("Ramp rate: "));
+      Serial.println(settings.rampRate);
+    } else if (isCommand(PSTR("rp:"))) {
+      settings.rampProfile = constrain(value, 0, RAMP_LENGHT - 1);
+      configureShaper();
+      Serial.print(F("Ramp profile: "));
+      Serial.println(settings.rampProfile);
+    } else if (isCommand(PSTR("ts"))) {
+      printTransition();
+    } else if (isCommand(PSTR("b"))) {
+      printBoot();
+    } else if (isCommand(PSTR("g"))) {
+      sendSettingsFrame();
+    } else if (isCommand(PSTR("cr"))) {
+      printControlRate();
+    } else if (isCommand(PSTR("e"))) {
+      printEnergy();
+    } else if (isCommand(PSTR("tp"))) {
+      printTips();
+    } else if (isCommand(PSTR("tp:"))) {
+      if (selectTip(value)) {
+        printTunnings();
+      } else {
+        Serial.println(F("Invalid tip!"));
+      }
+    } else if (isCommand(PSTR("tn:"))) {
+      strncpy(activeTipName, separator + 1, TIP_NAME_SIZE - 1);
+      activeTipName[TIP_NAME_SIZE - 1] = '\0';
+      saveTip(settings.activeTip);
+      Serial.print(F("Tip name: "));
+      Serial.println(activeTipName);
+    } else if (isCommand(PSTR("th:"))) {
+      tauHeater = constrain(value, 0, OBSERVER_TAU_MAX);
+      saveTip(settings.activeTip);
+      configureObserver();
+      Serial.print(F("Heater time constant: "));
+      Serial.println(tauHeater);
+    } else if (isCommand(PSTR("tk:"))) {
+      tauTip = constrain(value, 0, OBSERVER_TAU_MAX);
+      saveTip(settings.activeTip);
+      configureObserver();
+      Serial.print(F("Tip time constant: "));
+      Serial.println(tauTip);
+    } else if (isCommand(PSTR("tg:"))) {
+      heaterGain = constrain(value, 0, OBSERVER_GAIN_MAX);
+      saveTip(settings.activeTip);
+      configureObserver();
+      Serial.print(F("Heater gain: "));
+      Serial.println(heaterGain);
+    } else if (isCommand(PSTR("tl:"))) {
+      tipLoss = constrain(value, 0, OBSERVER_LOSS_MAX);
+      saveTip(settings.activeTip);
+      configureObserver();
+      Serial.print(F("Tip loss: "));
+      Serial.println(tipLoss);
+    } else if (isCommand(PSTR("id"))) {
+      printPlant();
+    } else if (isCommand(PSTR("ai:"))) {
+      if (value == 0) {
+        settings.adaptive = false;
+        setAdaptScale(1, 1);
+      } else if (identifier.isReady()) {
+        // the tunings are good now, keep them matched to this plant
+        refGain = identifier.gain();
+        refTau = identifier.tau();
+        settings.adaptive = true;
+      } else {
+        Serial.println(F("Plant not identified yet!"));
+      }
+      printPlant();
+    } else if (isCommand(PSTR("sb"))) {
+      printStandby();
+    } else if (isCommand(PSTR("ld:"))) {
+      // ld:<stage> <seconds> <celsius>
+      char *end;
+      byte stage = strtol(separator + 1, &end, 10);
+      uint16_t seconds = strtol(end, &end, 10);
+      uint16_t celsius = strtol(end, &end, 10);
+      if (stage == 1 && seconds >= 30 && seconds <= 300 && celsius <= 250) {
+        settings.standbyTime = seconds;
+        settings.standbyTemp = celsius;
+        printStandby();
+      } else if (stage >= 2 && stage <= STANDBY_STAGES && seconds <= 3600 && celsius <= 250) {
+        settings.ladder[stage - 2].time = seconds;
+        settings.ladder[stage - 2].temp = celsius;
+        printStandby();
+      } else {
+        Serial.println(F("Invalid stage!"));
+      }
+    } else if (isCommand(PSTR("ol"))) {
+      isLoggingObserver = !isLoggingObserver;
+      if (isLoggingObserver) {
+        Serial.println(F("ms,duty,sensor,tip"));
+      }
     } else {
       Serial.println(F("Unknown command!"));
     }
   }
 
   // rotary
+  BENCH_MARK(BENCH_ROTARY);
   if (view == VIEW_MAIN) {
     rotaryMain();
   } else if (view == VIEW_SETTINGS) {
     rotarySettings();
   }
 
+  // logo, banner and beep, one step per pass so they never hold the control loop
+  BENCH_MARK(BENCH_BOOT);
+  serviceBoot();
+
   // logo delay
-  if (isDisplayingLogo) {
-    if (millis() - logoMillis > 2000) { // show logo for 4 seconds
+  if (isDisplayingLogo && bootStage > BOOT_LOGO) {
+    if ((uint16_t)(millis16() - logoMillis) > LOGO_TIME) { // show logo
       view = VIEW_MAIN;
       isDisplayingLogo = false;
       updateLCD();
@@ -246,34 +570,31 @@ void loop() {
   }
 
   // standby time
-  if (!isOnStandBy) {
-    if (millis() - standByMillis > (1000 * settings.standbyTime)) {
-      tempBeforeEnteringStandby = Setpoint;
-      Setpoint = settings.standbyTemp;
-      isOnStandBy = true;
-
-    }
-  }
+  BENCH_MARK(BENCH_STANDBY);
+  updateStandby();
 
   // Control temperature
-  Input = getTemp();
-  if (Input < 0 || Input > 450) { // some protection
-    myPID.SetMode(MANUAL);
-    analogWrite(HEATER_PIN, 0);
-    pinMode(HEATER_PIN, INPUT);
-    view = VIEW_LOGO;
+  BENCH_MARK(BENCH_CONTROL);
+  if ((uint16_t)(millis16() - controlMillis) >= controlPeriod) {
+    controlTemperature();
+    updateControlRate();
   }
-  myPID.Compute();
-  analogWrite(HEATER_PIN, Output);
+  BENCH_MARK(BENCH_ENERGY);
+  energy.service(); // background save of the lifetime counters
 
   // LCD Update
-  if (millis() - lcdMillis > 250) { // lcd update delay
+  BENCH_MARK(BENCH_LCD);
+  if ((uint16_t)(millis16() - lcdMillis) > 250) { // lcd update delay
     blink = !blink;
     updateLCD();
-    lcdMillis = millis();
+    lcdMillis = millis16();
+  }
+  if (isReceivingFrame) {
+    collectFrame(); // the slowest stage, keep the 64 byte receive buffer from filling
   }
 
   // function timeout
+  BENCH_MARK(BENCH_HOUSEKEEPING);
   if (millis() - functionTimeout > 20000) {
     // only permits 20 seconds without action outside main
     // functionTimeout needs to be reset to millis() in every rotary event
@@ -285,18 +606,24 @@ void loop() {
   }
 
   // temperature delta per second
-  if (millis() - tempMillis > 1000) {
+  if ((uint16_t)(millis16() - tempMillis) > 1000) {
     double newTemp = getTemp();
     tempVariation = (newTemp / oldTemp) - 1;
     oldTemp = newTemp;
-    tempMillis = millis();
+    tempMillis = millis16();
+  }
+
+  // gains follow the tip as it wears
+  if ((uint16_t)(millis16() - adaptMillis) > ADAPT_PERIOD) {
+    adaptTunings();
+    adaptMillis = millis16();
   }
 
   // detect temperature drop and reset standby
   // if auto restore is enabled
   if (isOnStandBy) { // if on standby
 
-    if (settings.restore) { // if on auto restore
+    if (settings.restore && standbyStage != STANDBY_OFF && !isFaulted) { // off is cold, needs a click
 
       double powerOut = Output / settings.maxPower * 100;
       if (tempVariation < -0.032 && powerOut < 0.05) {
@@ -312,8 +639,8 @@ void loop() {
   }
 
   // Plotter
-  if (millis() - serialMillis > 1000 && isPlotting) { // Plot values
-    const char *spacer = " ";
+  if ((uint16_t)(millis16() - serialMillis) > 1000 && isPlotting) { // Plot values
+    const char spacer = ' ';
     Serial.print(Setpoint);
     Serial.print(spacer);
     Serial.print(Input);
@@ -332,9 +659,13 @@ void loop() {
     Serial.print(spacer);
     Serial.print(settings.standbyTime);
     Serial.print(spacer);
-    Serial.println(tempVariation, 5);
+    Serial.print(tempVariation, 5);
+    Serial.print(spacer);
+    Serial.print(pidSetpoint);
+    Serial.print(spacer);
+    Serial.println(controlPeriod);
 
-    serialMillis = millis();
+    serialMillis = millis16();
   }
 
   if (!isOnStandBy && beepAtSetpoint && Input >= Setpoint-5 && settings.sound){
@@ -345,28 +676,44 @@ void loop() {
 }
 
 void resetFailSafe() {
-  settings.firstBoot = 123;
-  settings.standbyTemp = SETTINGS_STANDBY_TEMP;
-  settings.standbyTime = SETTINGS_STANDBY_TIME;
-  settings.p = SETTINGS_P;
-  settings.i = SETTINGS_I;
-  settings.d = SETTINGS_D;
-  settings.m1 = SETTINGS_M1;
-  settings.m2 = SETTINGS_M2;
-  settings.m3 = SETTINGS_M3;
-  settings.tCorrection = SETTINGS_TEMP_CORRECTION;
-  settings.maxPower = SETTINGS_MAX_POWER;
-  settings.timeout = SETTINGS_TIMEOUT;
-  settings.lastMem = MEM1;
-  settings.sound = SETTINGS_SOUND;
-  settings.restore = SETTINGS_RESTORE;
-  myPID.SetTunings(settings.p, settings.i, settings.d);
+  loadDefaults();
   EEPROM.put(0, settings); // save values to eeprom
+  resetTips();
   Serial.println(F("Reseted!"));
   delay(500);
   software_Reboot();
 }
 
+void loadDefaults() {
+  settings.firstBoot = EEPROM_CHECK;
+  settings.standbyTemp = Board::standbyTemp;
+  settings.standbyTime = Board::standbyTime;
+  settings.p = Board::p;
+  settings.i = Board::i;
+  settings.d = Board::d;
+  settings.m1 = Board::m1;
+  settings.m2 = Board::m2;
+  settings.m3 = Board::m3;
+  settings.tCorrection = Board::tCorrection;
+  settings.maxPower = Board::maxPower;
+  settings.timeout = Board::timeout;
+  settings.lastMem = MEM1;
+  settings.sound = Board::sound;
+  settings.restore = Board::restore;
+  settings.rampRate = Board::rampRate;
+  settings.rampProfile = Board::rampProfile;
+  settings.activeTip = 0;
+  settings.ladder[0].time = Board::deepStandbyTime1;
+  settings.ladder[0].temp = Board::deepStandbyTemp1;
+  settings.ladder[1].time = Board::deepStandbyTime2;
+  settings.ladder[1].temp = Board::deepStandbyTemp2;
+  settings.adaptive = Board::adaptive;
+  strcpy_P(activeTipName, PSTR("TIP1"));
+  tauHeater = tauTip = heaterGain = tipLoss = 0;
+  refGain = refTau = 0;
+  applySettings();
+}
+
 void printTunnings() {
   Serial.print(F("The tunings  P: "));
   Serial.print(myPID.GetKp());
@@ -383,7 +730,7 @@ void software_Reboot() {
   }
 }
 
-void timerIsr() { encoder->service(); }
+void timerIsr() { encoder.service(); }
 
 void draw() {
   // graphic commands to redraw the complete screen should be placed here
@@ -418,16 +765,13 @@ void viewMain() {
   // common main view mode drawing
   // temperature
   u8g.setColorIndex(1);
-  u8g.setFont(u8g_font_freedoomr25n);
-  u8g.drawStr(0, 37, String((int)Setpoint).c_str());
-  u8g.drawCircle(59, 14, 2);
-  u8g.setFont(u8g_font_freedoomr10r);
-  u8g.drawStr(61, 37, "C");
+  char buf[6];
+  byte x = glyphsWidth(itoa((int)Setpoint, buf, 10), FONT_LARGE) + 2;
+  drawGlyphs(u8g, 0, 8, buf, FONT_LARGE, 1);
+  drawGlyphsP(u8g, x, 8, PSTR(GLYPH_DEGREE_STRING "C"), FONT_LARGE, 1);
   if (!isSavingMemory) {
     // render main view - normal
-    u8g.setColorIndex(1);
-    u8g.setFont(u8g_font_freedoomr10r);
-    u8g.drawStr(0, 12, String((int)(Input + 0.5)).c_str());
+    drawGlyphs(u8g, 0, 0, itoa((int)(Input + 0.5), buf, 10), FONT_SMALL, 1);
 
     // draw pwr-meter
     // unit bar height is 5px, 8 boxes separated by 2px
@@ -469,100 +813,118 @@ void viewMain() {
         settings.lastMem = MEM3;
       }
     } else {
-      u8g.drawStr(0, 49, "STAND BY");
+      drawGlyphsP(u8g, 0, 40, (standbyStage == STANDBY_OFF) ? PSTR("OFF") : PSTR("STAND BY"), FONT_SMALL, 1);
     }
 
   } else {
 
     // render main view - store
-    u8g.setColorIndex(1);
-    u8g.setFont(u8g_font_freedoomr10r);
-    u8g.drawStr(0, 12, "SELECT MEM");
-
-    if (blink) { // blink the memory icon
-      drawMemIcon(memoryToStore);
+    if (memoryToStore < MEM_TIP_FIRST) {
+      drawGlyphsP(u8g, 0, 0, PSTR("SELECT MEM"), FONT_SMALL, 1);
+      if (blink) { // blink the memory icon
+        drawMemIcon(memoryToStore);
+      }
+    } else {
+      drawGlyphsP(u8g, 0, 0, PSTR("SELECT TIP"), FONT_SMALL, 1);
+      if (blink) { // blink the tip name
+        readTipName(memoryToStore - MEM_TIP_FIRST, buf);
+        drawGlyphs(u8g, 0, 40, buf, FONT_SMALL, 1);
+      }
     }
   }
 }
 void viewSettings() {
+  char topBuf[8];
+  const char *topText = "";        // value, formatted in ram
+  const char *bottomText;            // unit, constant in flash
   switch (menuPosition) {
-    char topBuf[8];
   case MENU_EXIT: // exit
-    topText = "";
-    bottomText = "REBOOT";
+    bottomText = PSTR("REBOOT");
     break;
   case MENU_SB_TIME: // stand by time
-    topText = dtostrf(settings.standbyTime + 0.0f, 0, 0, topBuf);
-    bottomText = "SECONDS";
+    topText = utoa(settings.standbyTime, topBuf, 10);
+    bottomText = PSTR("SECONDS");
     break;
   case MENU_SB_TEMP: // stand by temperature
-    topText = dtostrf(settings.standbyTemp + 0.0f, 0, 0, topBuf);
-    bottomText = "CELSIUS";
+    topText = dtostrf(settings.standbyTemp, 0, 0, topBuf);
+    bottomText = PSTR("CELSIUS");
     break;
   case MENU_RESTORE: // restore temperature
-    topText = "";
-    bottomText = (settings.restore) ? "AUTO" : "MANUAL";
+    bottomText = (settings.restore) ? PSTR("AUTO") : PSTR("MANUAL");
     break;
   case MENU_PWR_OFF: // power off
-    topText = dtostrf(settings.timeout + 0.0f, 0, 0, topBuf);
-    bottomText = "MINUTES";
+    topText = utoa(settings.timeout, topBuf, 10);
+    bottomText = PSTR("MINUTES");
     break;
   case MENU_SOUND:
-    topText = "";
-    bottomText = (settings.sound) ? "ON" : "OFF";
+    bottomText = (settings.sound) ? PSTR("ON") : PSTR("OFF");
     break;
   case MENU_P: // P
     topText = dtostrf(settings.p, 0, 2, topBuf);
-    bottomText = "P";
+    bottomText = PSTR("P");
     break;
   case MENU_I: // I
     topText = dtostrf(settings.i, 0, 2, topBuf);
-    bottomText = "I";
+    bottomText = PSTR("I");
     break;
   case MENU_D: // D
     topText = dtostrf(settings.d, 0, 2, topBuf);
-    bottomText = "D";
+    bottomText = PSTR("D");
     break;
   case MENU_T_CORR: // temp correction
     topText = dtostrf(settings.tCorrection, 0, 2, topBuf);
-    bottomText = "FACTOR";
+    bottomText = PSTR("FACTOR");
     break;
   case MENU_MAX_PWR: // max power
-    topText = dtostrf(map(settings.maxPower, 0, 255, 0, 100) + 0.0f, 0, 0, topBuf);
-    bottomText = "%";
+    topText = itoa(map(settings.maxPower, 0, 255, 0, 100), topBuf, 10);
+    bottomText = PSTR("%");
+    break;
+  case MENU_RAMP_RATE: // setpoint ramp
+    if (settings.rampRate > 0) {
+      topText = utoa(settings.rampRate, topBuf, 10);
+      bottomText = PSTR("C/SEC");
+    } else {
+      bottomText = PSTR("OFF");
+    }
+    break;
+  case MENU_RAMP_TYPE: // setpoint ramp profile
+    if (settings.rampProfile == RAMP_LINEAR) {
+      bottomText = PSTR("LINEAR");
+    } else if (settings.rampProfile == RAMP_SCURVE) {
+      bottomText = PSTR("S-CURVE");
+    } else {
+      bottomText = PSTR("STEP");
+    }
     break;
   case MENU_SAVE_ALL: // save
-    topText = "";
-    bottomText = "EEPROM";
+    bottomText = PSTR("EEPROM");
     break;
   case MENU_RESET_ALL: // reset
-    topText = "";
-    bottomText = "DEFAULTS";
+    bottomText = PSTR("DEFAULTS");
     break;
   default:
-    topText = "";
-    bottomText = "";
+    bottomText = PSTR("");
     break;
   }
 
   // render the view
-  drawTitle(title[menuPosition]);
+  drawTitle((const char *)pgm_read_ptr(&title[menuPosition]));
   u8g.setColorIndex(1);
-  u8g.setFont(u8g_font_freedoomr25n);
+  byte topX = 42 - (glyphsWidth(topText, FONT_LARGE) / 2); // center
   if (isEditing) {
     if (blink) {
-      u8g.drawStr(42 - (u8g.getStrWidth(topText) / 2), 39, topText); // center
+      drawGlyphs(u8g, topX, 16, topText, FONT_LARGE, 1);
     }
   } else {
-    u8g.drawStr(42 - (u8g.getStrWidth(topText) / 2), 39, topText);
+    drawGlyphs(u8g, topX, 16, topText, FONT_LARGE, 1);
   }
-  u8g.setFont(u8g_font_freedoomr10r);
-  if (isEditing && topText == "") {
+  byte bottomX = 42 - (glyphsWidthP(bottomText, FONT_SMALL) / 2);
+  if (isEditing && topText[0] == '\0') {
     if (blink) {
-      u8g.drawStr(42 - (u8g.getStrWidth(bottomText) / 2), 50, bottomText);
+      drawGlyphsP(u8g, bottomX, 41, bottomText, FONT_SMALL, 1);
     }
   } else {
-    u8g.drawStr(42 - (u8g.getStrWidth(bottomText) / 2), 50, bottomText);
+    drawGlyphsP(u8g, bottomX, 41, bottomText, FONT_SMALL, 1);
   }
 
 }
@@ -570,7 +932,7 @@ void viewSettings() {
 // rotary behaviour
 void rotaryMain() {
 
-  encValue += encoder->getValue();
+  encValue += encoder.getValue();
   if (isOnStandBy) {
     encLast = encValue;
   }
@@ -582,14 +944,14 @@ void rotaryMain() {
       if (!isSavingMemory) {
         Setpoint = constrain(Setpoint + (5 * (encValue - encLast)), 100, 400);
       } else {
-        memoryToStore = constrain(memoryToStore + 1, 0, 2);
+        memoryToStore = constrain(memoryToStore + 1, 0, MEM_TIP_FIRST + TIP_SLOTS - 1);
       }
     }
     if (encValue < encLast) {
       if (!isSavingMemory) {
         Setpoint = constrain(Setpoint - (5 * (encLast - encValue)), 100, 400);
       } else {
-        memoryToStore = constrain(memoryToStore - 1, 0, 2);
+        memoryToStore = constrain(memoryToStore - 1, 0, MEM_TIP_FIRST + TIP_SLOTS - 1);
       }
     }
 
@@ -597,7 +959,7 @@ void rotaryMain() {
     updateLCD();
   }
 
-  ClickEncoder::Button b = encoder->getButton();
+  ClickEncoder::Button b = encoder.getButton();
 
   if (b == ClickEncoder::Clicked) {
 
@@ -624,11 +986,12 @@ void rotaryMain() {
         settings.m3 = Setpoint;
         settings.lastMem = MEM3;
         break;
-      default:
+      default: // a tip profile
+        selectTip(memoryToStore - MEM_TIP_FIRST);
         break;
       }
       EEPROM.put(0, settings);
-      Serial.println("Memory Saved!");
+      Serial.println((memoryToStore < MEM_TIP_FIRST) ? F("Memory Saved!") : F("Tip selected!"));
       isSavingMemory = false;
           bopLong();
     }
@@ -650,12 +1013,14 @@ void rotaryMain() {
 }
 
 void rotarySettings() {
-  ClickEncoder::Button b = encoder->getButton();
-  encValue += encoder->getValue();
+  ClickEncoder::Button b = encoder.getButton();
+  encValue += encoder.getValue();
 
   if (encValue != encLast) {
     bop();
     resetTimeouts();
+    byte step = (isFastCount) ? 10 : 5;
+    double fineStep = (isFastCount) ? 1 : 0.01;
 
     if (encValue > encLast) {
       if (!isEditing) { // if is not editing increment menu
@@ -668,8 +1033,7 @@ void rotarySettings() {
           settings.standbyTime = constrain(settings.standbyTime + 5, 30, 300);
           break;
         case MENU_SB_TEMP:
-          i = (isFastCount) ? 10 : 5;
-          settings.standbyTemp = constrain(settings.standbyTemp + i, 0, 250);
+          settings.standbyTemp = constrain(settings.standbyTemp + step, 0, 250);
           break;
         case MENU_RESTORE:
           settings.restore = true;
@@ -681,16 +1045,13 @@ void rotarySettings() {
           settings.sound = true;
           break;
         case MENU_P:
-          d = (isFastCount) ? 1 : 0.01;
-          settings.p = constrain(settings.p + d, 0, 30);
+          settings.p = constrain(settings.p + fineStep, 0, 30);
           break;
         case MENU_I:
-          d = (isFastCount) ? 1 : 0.01;
-          settings.i = constrain(settings.i + d, 0, 30);
+          settings.i = constrain(settings.i + fineStep, 0, 30);
           break;
         case MENU_D:
-          d = (isFastCount) ? 1 : 0.01;
-          settings.d = constrain(settings.d + d, 0, 30);
+          settings.d = constrain(settings.d + fineStep, 0, 30);
           break;
         case MENU_T_CORR:
           settings.tCorrection = constrain(settings.tCorrection + 0.01, 0.5, 1.5);
@@ -698,6 +1059,12 @@ void rotarySettings() {
         case MENU_MAX_PWR:
           settings.maxPower = constrain(settings.maxPower + 2, 50, 255);
           break;
+        case MENU_RAMP_RATE:
+          settings.rampRate = constrain(settings.rampRate + step / 5, 0, 100);
+          break;
+        case MENU_RAMP_TYPE:
+          settings.rampProfile = constrain(settings.rampProfile + 1, 0, RAMP_LENGHT - 1);
+          break;
         default:
           break;
         }
@@ -714,8 +1081,7 @@ void rotarySettings() {
           settings.standbyTime = constrain(settings.standbyTime - 5, 30, 300);
           break;
         case MENU_SB_TEMP:
-          i = (isFastCount) ? 10 : 5;
-          settings.standbyTemp = constrain(settings.standbyTemp - i, 0, 250);
+          settings.standbyTemp = constrain(settings.standbyTemp - step, 0, 250);
           break;
         case MENU_RESTORE:
           settings.restore = false;
@@ -727,16 +1093,13 @@ void rotarySettings() {
           settings.sound = false;
           break;
         case MENU_P:
-          d = (isFastCount) ? 1 : 0.01;
-          settings.p = constrain(settings.p - d, 0, 30);
+          settings.p = constrain(settings.p - fineStep, 0, 30);
           break;
         case MENU_I:
-          d = (isFastCount) ? 1 : 0.01;
-          settings.i = constrain(settings.i - d, 0, 30);
+          settings.i = constrain(settings.i - fineStep, 0, 30);
           break;
         case MENU_D:
-          d = (isFastCount) ? 1 : 0.01;
-          settings.d = constrain(settings.d - d, 0, 30);
+          settings.d = constrain(settings.d - fineStep, 0, 30);
           break;
         case MENU_T_CORR:
           settings.tCorrection = constrain(settings.tCorrection - 0.01, 0.5, 1.5);
@@ -744,6 +1107,12 @@ void rotarySettings() {
         case MENU_MAX_PWR:
           settings.maxPower = constrain(settings.maxPower - 2, 50, 255);
           break;
+        case MENU_RAMP_RATE:
+          settings.rampRate = constrain(settings.rampRate - step / 5, 0, 100);
+          break;
+        case MENU_RAMP_TYPE:
+          settings.rampProfile = constrain(settings.rampProfile - 1, 0, RAMP_LENGHT - 1);
+          break;
         default:
           break;
         }
@@ -763,7 +1132,7 @@ void rotarySettings() {
     } else if (menuPosition == MENU_RESET_ALL && !isEditing) { // reset
       resetFailSafe();
     } else if (menuPosition == MENU_SAVE_ALL && !isEditing) { // save
-      EEPROM.put(0, settings);
+      saveSettings();
       delay(100);
       software_Reboot();
     }
@@ -805,79 +1174,805 @@ void drawMemIcon(byte memory) {
   switch (memory) {
 
   case MEM1:
-    u8g.setFont(u8g_font_freedoomr10r);
     u8g.setColorIndex(1);
     u8g.drawBox(0, 36, 18, 12);
-    u8g.setColorIndex(0);
-    u8g.drawStr(2, 49, "M1");
+    drawGlyphsP(u8g, 3, 39, PSTR("M1"), FONT_SMALL, 0);
     break;
   case MEM2:
-    u8g.setFont(u8g_font_freedoomr10r);
     u8g.setColorIndex(1);
     u8g.drawBox(20, 36, 18, 12);
-    u8g.setColorIndex(0);
-    u8g.drawStr(22, 49, "M2");
+    drawGlyphsP(u8g, 23, 39, PSTR("M2"), FONT_SMALL, 0);
     break;
   case MEM3:
-    u8g.setFont(u8g_font_freedoomr10r);
     u8g.setColorIndex(1);
     u8g.drawBox(39, 36, 18, 12);
-    u8g.setColorIndex(0);
-    u8g.drawStr(41, 49, "M3");
+    drawGlyphsP(u8g, 42, 39, PSTR("M3"), FONT_SMALL, 0);
     break;
   default:
     break;
   }
 }
 
-double getTemp() { return therm.temperature() * settings.tCorrection; }
+double getTemp() { return readThermistor() * settings.tCorrection; }
+
+void configureObserver() {
+  observer.configure(tauHeater, tauTip, heaterGain, tipLoss);
+  observer.reset(sensorTemp, sensorTemp * settings.tCorrection); // start from the old scalar estimate
+}
 
 void resetStandby() {
   if (isOnStandBy) {
     // restore temperatureif already on standby
     Setpoint = tempBeforeEnteringStandby;
     beepAtSetpoint = true;
+    wakeStage = (standbyStage == STANDBY_OFF) ? STANDBY_STAGES : standbyStage - 1;
+    wakeMillis = millis();
+    isWaking = true;
+    if (Setpoint - Input > REHEAT_MIN_DELTA && !isFaulted) {
+      isReheating = true;
+      myPID.SetMode(MANUAL); // Output is driven by reheat() until the handoff
+    } else if (standbyStage == STANDBY_OFF && !isFaulted) {
+      myPID.SetMode(AUTOMATIC); // off held it in MANUAL with Output at 0, the integral starts there
+    }
   }
   isOnStandBy = false;
+  standbyStage = 0;
+  standByMillis = idleMillis = millis();
+}
+
+uint16_t stageTime(byte stage) { return (stage == 1) ? settings.standbyTime : settings.ladder[stage - 2].time; }
+
+uint16_t stageTemp(byte stage) { return (stage == 1) ? settings.standbyTemp : settings.ladder[stage - 2].temp; }
+
+void updateStandby() {
+  if (standbyStage == STANDBY_OFF) {
+    return;
+  }
+  if (millis() - idleMillis > 60000UL * settings.timeout) {
+    enterStandby(STANDBY_OFF);
+    return;
+  }
+  byte next = standbyStage + 1;
+  if (next <= STANDBY_STAGES && stageTime(next) > 0 && millis() - standByMillis > 1000UL * stageTime(next)) {
+    enterStandby(next);
+  }
+}
+
+void enterStandby(byte stage) {
+  if (!isOnStandBy) {
+    tempBeforeEnteringStandby = Setpoint;
+  }
+  isOnStandBy = true;
+  standbyStage = stage;
   standByMillis = millis();
-  
+  Setpoint = (stage == STANDBY_OFF) ? 0 : stageTemp(stage);
+  if (stage == STANDBY_OFF) { // off whatever the tunings, a setpoint of 0 alone doesn't hold the output at 0
+    myPID.SetMode(MANUAL);
+    isReheating = false;
+    Output = 0;
+  }
+}
+
+void reheat() {
+  if (isFaulted) {
+    isReheating = false; // the cutoff holds, nothing re-arms the PID
+    return;
+  }
+  // full power until the rise still to come from the heater lag would carry the tip to the setpoint
+  double lead = (tauHeater > 0) ? tauHeater : REHEAT_LEAD_TIME;
+  if (Input + inputSlope * lead < Setpoint - REHEAT_HANDOFF_MARGIN) {
+    Output = settings.maxPower;
+    return;
+  }
+  isReheating = false;
+  Output = 0; // PID_v1 starts its integral from Output
+  shaper.reset(Input);
+  myPID.SetMode(AUTOMATIC);
+}
+
+void adaptTunings() {
+  if (!settings.adaptive || refGain <= 0 || !identifier.isReady() || myPID.GetMode() != AUTOMATIC) {
+    return;
+  }
+  // keep the loop gain of the tunings: P and D go with tau / gain, I with 1 / gain
+  double gain = identifier.gain();
+  double scale = constrain(identifier.tau() / refTau * refGain / gain, ADAPT_SCALE_MIN, ADAPT_SCALE_MAX);
+  double integralScale = constrain(refGain / gain, ADAPT_SCALE_MIN, ADAPT_SCALE_MAX);
+  if (fabs(scale / adaptScale - 1) > ADAPT_DEADBAND || fabs(integralScale / adaptIntegralScale - 1) > ADAPT_DEADBAND) {
+    setAdaptScale(scale, integralScale);
+  }
+}
+
+void setAdaptScale(double scale, double integralScale) {
+  // the running tunings over the old scales are the base, p:, i: and d: tweaks included
+  myPID.SetTunings(myPID.GetKp() / adaptScale * scale, myPID.GetKi() / adaptIntegralScale * integralScale,
+                   myPID.GetKd() / adaptScale * scale);
+  adaptScale = scale;
+  adaptIntegralScale = integralScale;
+}
+
+void printPlant() {
+  Serial.print(F("Plant gain: "));
+  Serial.print(identifier.gain());
+  Serial.print(F(" C, tau: "));
+  Serial.print(identifier.tau());
+  Serial.print(F(" s, samples: "));
+  Serial.print(identifier.samples());
+  Serial.print(F(", trace: "));
+  Serial.print(identifier.trace(), 3);
+  Serial.println(identifier.isReady() ? F(", ready") : F(", identifying"));
+  Serial.print(F("Adaptive: "));
+  Serial.print(settings.adaptive ? F("on") : F("off"));
+  Serial.print(F(", reference: "));
+  Serial.print(refGain);
+  Serial.print(F(" C/"));
+  Serial.print(refTau);
+  Serial.print(F(" s, scale P/D: "));
+  Serial.print(adaptScale);
+  Serial.print(F(", I: "));
+  Serial.println(adaptIntegralScale);
+}
+
+void printStandby() {
+  for (byte stage = 1; stage <= STANDBY_STAGES + 1; stage++) {
+    byte n = stage - 1; // statistics index
+    if (stage <= STANDBY_STAGES) {
+      Serial.print(stage);
+      Serial.print(F(": after "));
+      Serial.print(stageTime(stage));
+      Serial.print(F(" s at "));
+      Serial.print(stageTemp(stage));
+      Serial.print(F(" C"));
+    } else {
+      Serial.print(F("off: after "));
+      Serial.print(settings.timeout);
+      Serial.print(F(" min idle"));
+    }
+    Serial.print(F(", ready in "));
+    if (readyCount[n] > 0) {
+      Serial.print(readyLast[n]);
+      Serial.print(F(" ms, avg "));
+      Serial.print(readyTotal[n] / readyCount[n]);
+      Serial.print(F(" ms over "));
+      Serial.println(readyCount[n]);
+    } else {
+      Serial.println('-');
+    }
+  }
 }
 
 void drawTitle(const char *title) {
   u8g.setColorIndex(1);
   u8g.drawRBox(0, 0, 83, 12, 2);
-  u8g.setColorIndex(0);
-  // u8g.setFont(u8g_font_6x10r);
-  u8g.setFont(u8g_font_freedoomr10r);
-  u8g.drawStr(42 - (u8g.getStrWidth(title) / 2), 13, title);
+  drawGlyphsP(u8g, 42 - (glyphsWidthP(title, FONT_SMALL) / 2), 3, title, FONT_SMALL, 0);
 }
 
+bool hasSound() { return Board::buzzerPin != NO_PIN && settings.sound; } // no buzzer compiles the sounds out
+
 void beep() {
-  if (settings.sound) {
-    tone(BUZZER_PIN, 1000, 100);
+  if (hasSound()) {
+    tone(Board::buzzerPin, 1000, 100);
   }
 }
 void beepBeep() {
-  if (settings.sound) {
-    tone(BUZZER_PIN, 1000, 100);
+  if (hasSound()) {
+    tone(Board::buzzerPin, 1000, 100);
     delay(100);
-    tone(BUZZER_PIN, 1000, 100);
+    tone(Board::buzzerPin, 1000, 100);
   }
 }
 void beepBop() {
-  if (settings.sound) {
-    tone(BUZZER_PIN, 1000, 100);
+  if (hasSound()) {
+    tone(Board::buzzerPin, 1000, 100);
     delay(100);
-    tone(BUZZER_PIN, 500, 100);
+    tone(Board::buzzerPin, 500, 100);
   }
 }
 void bop() {
-  if (settings.sound) {
-    tone(BUZZER_PIN, 500, 50);
+  if (hasSound()) {
+    tone(Board::buzzerPin, 500, 50);
   }
 }
 void bopLong() {
-  if (settings.sound) {
-    tone(BUZZER_PIN, 500, 500);
+  if (hasSound()) {
+    tone(Board::buzzerPin, 500, 500);
+  }
+}
+
+uint16_t millis16() { return (uint16_t)millis(); }
+
+bool isCommand(const char *cmd) {
+  byte n = strlen_P(cmd);
+  if (strncmp_P(serialBuffer, cmd, n) != 0) {
+    return false;
+  }
+  // "x:" commands carry a value, the others must match the whole line
+  return pgm_read_byte(cmd + n - 1) == ':' || serialBuffer[n] == '\0';
+}
+
+// fills the free ram with a canary before any constructor runs,
+// the stack erases it as it grows so the untouched part is the high-water-mark
+void paintStack() __attribute__((naked)) __attribute__((used)) __attribute__((section(".init3")));
+void paintStack() {
+  uint8_t *p = &_end;
+  while (p <= &__stack) {
+    *p = STACK_CANARY;
+    p++;
+  }
+}
+
+uint16_t freeRam() {
+  uint8_t top;
+  uint8_t *heapEnd = (__brkval == 0) ? &__heap_start : (uint8_t *)__brkval;
+  return &top - heapEnd;
+}
+
+uint16_t stackHighWater() {
+  const uint8_t *p = (__brkval == 0) ? &_end : (uint8_t *)__brkval;
+  while (p <= &__stack && *p == STACK_CANARY) {
+    p++;
+  }
+  return &__stack - p + 1;
+}
+
+void printMemory() {
+  Serial.print(F("Static RAM: "));
+  Serial.print((uint16_t)(&_end - &__data_start));
+  Serial.print(F(", free: "));
+  Serial.print(freeRam());
+  Serial.print(F(", stack max: "));
+  Serial.print(stackHighWater());
+  Serial.print(F(", total: "));
+  Serial.println((uint16_t)(&__stack - &__data_start + 1));
+}
+
+void configureShaper() { shaper.configure(settings.rampProfile, settings.rampRate, Board::rampAccel); }
+
+void trackTransition() {
+  if (Setpoint != transitionTarget) { // new target, restart the measurement
+    transitionTarget = Setpoint;
+    transitionMillis = millis();
+    timeToSetpoint = 0;
+    overshoot = 0;
+    isTransitionUp = Setpoint > Input;
+  }
+  if (timeToSetpoint == 0 && fabs(Input - Setpoint) <= TRANSITION_BAND) {
+    timeToSetpoint = max(millis() - transitionMillis, 1UL);
+  }
+  double excursion = (isTransitionUp) ? Input - Setpoint : Setpoint - Input;
+  if (excursion > overshoot) {
+    overshoot = excursion;
+  }
+}
+
+void printTransition() {
+  Serial.print(F("Transition to "));
+  Serial.print(transitionTarget);
+  Serial.print(F(" time: "));
+  if (timeToSetpoint > 0) {
+    Serial.print(timeToSetpoint);
+    Serial.print(F(" ms"));
+  } else {
+    Serial.print(F("not reached"));
+  }
+  Serial.print(F(", overshoot: "));
+  Serial.println(overshoot);
+}
+
+void applySettings() {
+  myPID.SetTunings(settings.p, settings.i, settings.d);
+  adaptScale = adaptIntegralScale = 1;
+  myPID.SetOutputLimits(0, settings.maxPower);
+  configureShaper();
+}
+
+bool isValidLadder(const eeprom_map_t &s) {
+  for (byte n = 0; n < STANDBY_DEEP_STAGES; n++) {
+    if (s.ladder[n].time > 3600 || s.ladder[n].temp > 250) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool isValidSettings(const eeprom_map_t &s) {
+  return s.firstBoot == EEPROM_CHECK && s.standbyTime >= 30 && s.standbyTime <= 300 && s.standbyTemp >= 0 &&
+         s.standbyTemp <= 250 && s.p >= 0 && s.p <= 30 && s.i >= 0 && s.i <= 30 && s.d >= 0 && s.d <= 30 &&
+         s.m1 >= 100 && s.m1 <= 400 && s.m2 >= 100 && s.m2 <= 400 && s.m3 >= 100 && s.m3 <= 400 &&
+         s.tCorrection >= 0.5 && s.tCorrection <= 1.5 && s.maxPower >= 50 && s.timeout >= 10 && s.timeout <= 120 &&
+         s.lastMem <= MEM3 && s.rampRate <= 100 && s.rampProfile < RAMP_LENGHT && s.activeTip < TIP_SLOTS &&
+         isValidLadder(s);
+}
+
+void writeHexByte(uint8_t b) {
+  Serial.write(frameHexDigit(b >> 4));
+  Serial.write(frameHexDigit(b & 0x0F));
+}
+
+void collectFrame() {
+  while (!isFrameComplete && Serial.available() > 0) {
+    char c = Serial.read();
+    int8_t value = frameHexValue(c);
+    frameMillis = millis16();
+    if (c == '\n') {
+      isFrameComplete = true; // what follows is the next line
+    } else if (c == '\r') {
+      continue;
+    } else if (value < 0 || frameDigits >= FRAME_BUFFER_SIZE * 2) {
+      isFrameBad = true;
+    } else if (frameDigits & 1) {
+      frameBuffer[frameDigits++ / 2] |= value;
+    } else {
+      frameBuffer[frameDigits++ / 2] = value << 4;
+    }
+  }
+}
+
+void sendFrame(uint8_t flags, const void *data, uint8_t size) {
+  const uint8_t header[FRAME_HEADER_SIZE] = {EEPROM_CHECK, flags, size};
+  const uint8_t *payload = (const uint8_t *)data;
+  uint16_t crc = 0xFFFF;
+  Serial.write(FRAME_START);
+  for (byte n = 0; n < FRAME_HEADER_SIZE; n++) {
+    writeHexByte(header[n]);
+    crc = frameCrc(crc, header[n]);
+  }
+  for (byte n = 0; n < size; n++) {
+    writeHexByte(payload[n]);
+    crc = frameCrc(crc, payload[n]);
+  }
+  writeHexByte(crc & 0xFF);
+  writeHexByte(crc >> 8);
+  Serial.println();
+}
+
+void sendSettingsFrame() {
+  // the settings frame goes last, it closes the clone
+  for (byte slot = 0; slot < TIP_SLOTS; slot++) {
+    tip_frame_t frame;
+    frame.slot = slot;
+    EEPROM.get(tipAddress(slot), frame.tip);
+    sendFrame(FRAME_TIP, &frame, sizeof(tip_frame_t));
+  }
+  sendFrame(0, &settings, sizeof(eeprom_map_t));
+}
+
+void receiveSettingsFrame() {
+  // the whole frame is staged and checked, nothing changes unless all of it is good
+  union {
+    eeprom_map_t settings;
+    tip_frame_t tip;
+  } staged;
+  const uint8_t *header = frameBuffer;
+  uint8_t size = (header[1] & FRAME_TIP) ? sizeof(tip_frame_t) : sizeof(eeprom_map_t);
+  uint16_t crc = 0xFFFF;
+  const __FlashStringHelper *error = NULL;
+
+  if (isFrameBad || frameDigits < FRAME_HEADER_SIZE * 2) {
+    error = F("bad frame");
+  } else if (header[0] != EEPROM_CHECK) {
+    error = F("version");
+  } else if (header[2] != size || frameDigits != (FRAME_HEADER_SIZE + size + 2) * 2) {
+    error = F("length");
+  }
+  for (byte n = 0; n < FRAME_HEADER_SIZE + size && error == NULL; n++) {
+    crc = frameCrc(crc, frameBuffer[n]);
+  }
+  const uint8_t *crcBytes = frameBuffer + FRAME_HEADER_SIZE + size;
+  if (error == NULL && crc != (crcBytes[0] | (crcBytes[1] << 8))) {
+    error = F("crc");
+  }
+  if (error == NULL) {
+    memcpy(&staged, frameBuffer + FRAME_HEADER_SIZE, size);
+  }
+  if (error == NULL && (header[1] & FRAME_TIP) && (staged.tip.slot >= TIP_SLOTS || !isValidTip(staged.tip.tip))) {
+    error = F("out of range");
+  } else if (error == NULL && !(header[1] & FRAME_TIP) && !isValidSettings(staged.settings)) {
+    error = F("out of range");
+  } else if (error == NULL && !(header[1] & FRAME_TIP) && stagedTipMask != 0 && stagedTipMask != (1 << TIP_SLOTS) - 1) {
+    error = F("tips"); // part of a clone is missing
+  }
+
+  if (error != NULL) {
+    stagedTipMask = 0; // a failed frame drops the whole clone
+    Serial.print(F("#ERR "));
+    Serial.println(error);
+    return;
+  }
+  if (header[1] & FRAME_TIP) {
+    if (staged.tip.slot == 0) {
+      stagedTipMask = 0; // a new clone starts
+    }
+    stagedTips[staged.tip.slot] = staged.tip.tip;
+    stagedTipMask |= 1 << staged.tip.slot;
+    Serial.println(F("#OK"));
+    return;
+  }
+  settings = staged.settings;
+  if (stagedTipMask != 0) {
+    // without persist only the active tip name and model are used until a reboot
+    if (header[1] & FRAME_PERSIST) {
+      for (byte slot = 0; slot < TIP_SLOTS; slot++) {
+        EEPROM.put(tipAddress(slot), stagedTips[slot]);
+      }
+    }
+    applyTipModel(stagedTips[settings.activeTip]);
+    stagedTipMask = 0;
+  } else {
+    loadTipModel(settings.activeTip);
+  }
+  applySettings();
+  if (header[1] & FRAME_PERSIST) {
+    saveSettings();
+  }
+  Serial.println(F("#OK"));
+}
+
+void controlTemperature() {
+  uint32_t start = micros();
+  uint16_t now = millis16();
+  controlDt = now - sampleMillis; // a late sample integrates the time it really took
+  sampleMillis = now;
+  // the thermistor reads the heater, the PID and the display want the tip
+  sensorTemp = readThermistor();
+  if (observer.isEnabled()) {
+    Input = observer.update(sensorTemp, Output / 255.0, controlDt);
+  } else {
+    Input = sensorTemp * settings.tCorrection;
+  }
+  identifier.update(Output / 255.0, Input, controlDt); // Output has been on for the last period
+  if (sensorTemp * settings.tCorrection < 0 || sensorTemp * settings.tCorrection > 450) { // some protection
+    isFaulted = true;
+    view = VIEW_LOGO;
+  }
+  if (isFaulted) { // stays off whatever wakes the iron
+    myPID.SetMode(MANUAL);
+    analogWrite(Board::Heater::pin, 0);
+    pinMode(Board::Heater::pin, INPUT);
+    isReheating = false;
+    Output = 0;
+  }
+  if (isReheating) {
+    reheat();
+  }
+  bool heaterLimited = Output >= settings.maxPower || Output <= 0;
+  pidSetpoint = shaper.update(Setpoint, Input, heaterLimited, controlDt);
+  // PID_v1 refuses to compute until SampleTime after its own last compute, so the loop is
+  // scheduled from the same moment: the next sample comes controlPeriod later plus the
+  // thermistor read (over 1 ms of conversions), which covers Compute() reading millis() a tick later
+  controlMillis = millis16();
+  myPID.Compute();
+  if (!isFaulted) { // analogWrite() would make the pin an output again
+    analogWrite(Board::Heater::pin, Output);
+  }
+  if (firstPwmMicros == 0) {
+    firstPwmMicros = micros();
+  }
+  if (bootReadyMillis == 0 && fabs(Input - Setpoint) <= TRANSITION_BAND) {
+    bootReadyMillis = millis();
+  }
+  if (isWaking && fabs(Input - Setpoint) <= TRANSITION_BAND) {
+    isWaking = false;
+    readyLast[wakeStage] = millis() - wakeMillis;
+    readyTotal[wakeStage] += readyLast[wakeStage];
+    readyCount[wakeStage]++;
+  }
+  energy.sample(Output, Output >= settings.maxPower, Setpoint, controlDt);
+  if (isLoggingObserver) { // raw data for tools/observer_calibration
+    Serial.print(millis());
+    Serial.print(',');
+    Serial.print(Output / 255.0, 3);
+    Serial.print(',');
+    Serial.print(sensorTemp);
+    Serial.print(',');
+    Serial.println(Input);
+  }
+  trackTransition();
+  controlMicros += micros() - start;
+  controlSamples++;
+}
+
+void updateControlRate() {
+  // slope low pass filtered over about 4 samples, the thermistor reading is noisy
+  double slope = (Input - lastInput) * 1000 / max(controlDt, (uint16_t)1);
+  inputSlope += (slope - inputSlope) / 4;
+  lastInput = Input;
+
+  double error = fabs(Setpoint - Input);
+  double absSlope = fabs(inputSlope);
+  uint16_t period;
+  if (error > CONTROL_FAST_ERROR || absSlope > CONTROL_FAST_SLOPE || shaper.isRamping()) {
+    period = CONTROL_PERIOD_FAST;
+    settledMillis = millis16();
+  } else if (error > CONTROL_SETTLED_ERROR || absSlope > CONTROL_SETTLED_SLOPE) {
+    period = CONTROL_PERIOD_NORMAL;
+    settledMillis = millis16();
+  } else if ((uint16_t)(millis16() - settledMillis) > CONTROL_SETTLED_TIME) {
+    period = CONTROL_PERIOD_SLOW;
+  } else {
+    period = max(controlPeriod, (uint16_t)CONTROL_PERIOD_NORMAL); // settling, not slow yet
+  }
+  if (period != controlPeriod) {
+    setControlPeriod(period);
+  }
+}
+
+void setControlPeriod(uint16_t period) {
+  // PID_v1 keeps ki and kd per sample, SetSampleTime() rescales them to the new period
+  myPID.SetSampleTime(period);
+  controlPeriod = period;
+  if (!isPlotting) { // don't break the plotter columns
+    Serial.print(F("Control period: "));
+    Serial.print(period);
+    Serial.println(F(" ms"));
+  }
+}
+
+void printControlRate() {
+  uint32_t elapsed = millis() - statsMillis;
+  uint32_t average = (controlSamples > 0) ? controlMicros / controlSamples : 0;
+  // what the same samples would cost if the loop always ran at the fast period
+  uint32_t fastMicros = average * (elapsed / CONTROL_PERIOD_FAST);
+  Serial.print(F("Control period: "));
+  Serial.print(controlPeriod);
+  Serial.print(F(" ms, samples: "));
+  Serial.print(controlSamples);
+  Serial.print(F(" in "));
+  Serial.print(elapsed);
+  Serial.print(F(" ms, "));
+  Serial.print(average);
+  Serial.print(F(" us each, cpu: "));
+  Serial.print(elapsed > 0 ? controlMicros / (elapsed * 10.0) : 0);
+  Serial.print(F("%, saved: "));
+  Serial.print(fastMicros > controlMicros ? (fastMicros - controlMicros) / 1000 : 0);
+  Serial.println(F(" ms of cpu"));
+  controlMicros = 0;
+  controlSamples = 0;
+  statsMillis = millis();
+}
+
+void printEnergy() {
+  Serial.print(F("Session: "));
+  Serial.print(energy.sessionFullPowerSeconds() * Board::heaterWatts);
+  Serial.print(F(" J, "));
+  Serial.print(energy.sessionRunSeconds());
+  Serial.print(F(" s on, "));
+  Serial.print(energy.sessionSaturationSeconds());
+  Serial.println(F(" s at max power"));
+  Serial.print(F("Lifetime: "));
+  Serial.print(energy.lifetimeFullPowerSeconds() * Board::heaterWatts / 3600);
+  Serial.print(F(" Wh, "));
+  Serial.print(energy.lifetimeRunSeconds() / 3600.0);
+  Serial.print(F(" h on, "));
+  Serial.print(energy.lifetimeSaturationSeconds() / 3600.0);
+  Serial.println(F(" h at max power"));
+  for (byte band = 0; band < ENERGY_BANDS; band++) {
+    // band limits, the first and last are open
+    if (band == 0) {
+      Serial.print('<');
+      Serial.print(ENERGY_BAND_START);
+    } else if (band == ENERGY_BANDS - 1) {
+      Serial.print(F(">="));
+      Serial.print(ENERGY_BAND_START + (band - 1) * ENERGY_BAND_WIDTH);
+    } else {
+      Serial.print(ENERGY_BAND_START + (band - 1) * ENERGY_BAND_WIDTH);
+      Serial.print('-');
+      Serial.print(ENERGY_BAND_START + band * ENERGY_BAND_WIDTH - 1);
+    }
+    Serial.print(F(" C: "));
+    Serial.print(energy.bandDuty(band) * 100);
+    Serial.print(F("% avg duty over "));
+    Serial.print(energy.bandSeconds(band));
+    Serial.println(F(" s"));
+  }
+}
+
+void saveSettings() {
+  EEPROM.put(0, settings);
+  saveTip(settings.activeTip);
+}
+
+int tipAddress(byte slot) { return EEPROM_TIPS_ADDRESS + slot * sizeof(tip_profile_t); }
+
+void loadTipModel(byte slot) {
+  tip_profile_t tip;
+  EEPROM.get(tipAddress(slot), tip);
+  if (!isValidTip(tip)) {
+    defaultTip(slot, tip); // no model rather than a broken one
+  }
+  applyTipModel(tip);
+}
+
+void applyTipModel(const tip_profile_t &tip) {
+  memcpy(activeTipName, tip.name, TIP_NAME_SIZE);
+  activeTipName[TIP_NAME_SIZE - 1] = '\0';
+  tauHeater = tip.tauHeater;
+  tauTip = tip.tauTip;
+  heaterGain = tip.heaterGain;
+  tipLoss = tip.tipLoss;
+  refGain = tip.refGain;
+  refTau = tip.refTau;
+  configureObserver();
+  identifier.reset(); // another tip, another plant
+}
+
+bool isValidTip(const tip_profile_t &tip) {
+  // model terms are 0 when unknown, the range checks also turn away nan and infinity
+  return tip.p >= 0 && tip.p <= 30 && tip.i >= 0 && tip.i <= 30 && tip.d >= 0 && tip.d <= 30 &&
+         tip.tCorrection >= 0.5 && tip.tCorrection <= 1.5 && tip.maxPower >= 50 &&
+         tip.tauHeater >= 0 && tip.tauHeater <= OBSERVER_TAU_MAX && tip.tauTip >= 0 && tip.tauTip <= OBSERVER_TAU_MAX &&
+         tip.heaterGain >= 0 && tip.heaterGain <= OBSERVER_GAIN_MAX && tip.tipLoss >= 0 &&
+         tip.tipLoss <= OBSERVER_LOSS_MAX &&
+         ((tip.refGain == 0 && tip.refTau == 0) || (tip.refGain >= RLS_GAIN_MIN && tip.refGain <= RLS_GAIN_MAX &&
+                                                     tip.refTau >= RLS_TAU_MIN && tip.refTau <= RLS_TAU_MAX));
+}
+
+bool selectTip(byte slot) {
+  if (slot >= TIP_SLOTS) {
+    return false;
+  }
+  tip_profile_t tip;
+  EEPROM.get(tipAddress(slot), tip);
+  if (!isValidTip(tip)) {
+    return false;
+  }
+  // everything changes between two control samples, the PID never sees half of a profile
+  settings.activeTip = slot;
+  settings.p = tip.p;
+  settings.i = tip.i;
+  settings.d = tip.d;
+  settings.tCorrection = tip.tCorrection;
+  settings.maxPower = tip.maxPower;
+  loadTipModel(slot);
+  applySettings();
+  return true;
+}
+
+void saveTip(byte slot) {
+  tip_profile_t tip;
+  memcpy(tip.name, activeTipName, TIP_NAME_SIZE);
+  tip.p = settings.p;
+  tip.i = settings.i;
+  tip.d = settings.d;
+  tip.tCorrection = settings.tCorrection;
+  tip.maxPower = settings.maxPower;
+  tip.tauHeater = tauHeater;
+  tip.tauTip = tauTip;
+  tip.heaterGain = heaterGain;
+  tip.tipLoss = tipLoss;
+  tip.refGain = refGain;
+  tip.refTau = refTau;
+  EEPROM.put(tipAddress(slot), tip);
+}
+
+void defaultTip(byte slot, tip_profile_t &tip) {
+  memset(&tip, 0, sizeof(tip_profile_t)); // no model identified yet
+  strcpy_P(tip.name, PSTR("TIP"));
+  tip.name[3] = '1' + slot;
+  tip.p = settings.p;
+  tip.i = settings.i;
+  tip.d = settings.d;
+  tip.tCorrection = settings.tCorrection;
+  tip.maxPower = settings.maxPower;
+}
+
+void resetTips() {
+  for (byte slot = 0; slot < TIP_SLOTS; slot++) {
+    tip_profile_t tip;
+    defaultTip(slot, tip); // settings hold the defaults here
+    EEPROM.put(tipAddress(slot), tip);
+  }
+  loadTipModel(settings.activeTip);
+}
+
+bool saveDefaultsByte() {
+  // tips first, then the settings backwards so the check byte goes last:
+  // a power cut halfway boots on the defaults again
+  const uint16_t tipsSize = TIP_SLOTS * sizeof(tip_profile_t);
+  if (!eeprom_is_ready()) {
+    return false; // previous byte still being written
+  }
+  if (defaultsIndex < tipsSize) {
+    tip_profile_t tip;
+    defaultTip(defaultsIndex / sizeof(tip_profile_t), tip);
+    EEPROM.update(EEPROM_TIPS_ADDRESS + defaultsIndex, ((const uint8_t *)&tip)[defaultsIndex % sizeof(tip_profile_t)]);
+  } else {
+    uint16_t n = sizeof(eeprom_map_t) - 1 - (defaultsIndex - tipsSize);
+    EEPROM.update(n, ((const uint8_t *)&settings)[n]);
+  }
+  defaultsIndex++;
+  if (defaultsIndex < tipsSize + sizeof(eeprom_map_t)) {
+    return false;
+  }
+  loadTipModel(settings.activeTip);
+  return true;
+}
+
+void readTipName(byte slot, char *name) {
+  for (byte n = 0; n < TIP_NAME_SIZE - 1; n++) { // name is the first field
+    name[n] = EEPROM.read(tipAddress(slot) + n);
+  }
+  name[TIP_NAME_SIZE - 1] = '\0';
+}
+
+void printTips() {
+  for (byte slot = 0; slot < TIP_SLOTS; slot++) {
+    tip_profile_t tip;
+    EEPROM.get(tipAddress(slot), tip);
+    tip.name[TIP_NAME_SIZE - 1] = '\0';
+    Serial.print(slot);
+    Serial.print(slot == settings.activeTip ? '*' : ' ');
+    Serial.print(tip.name);
+    Serial.print(F(" P: "));
+    Serial.print(tip.p);
+    Serial.print(F(", I: "));
+    Serial.print(tip.i);
+    Serial.print(F(", D: "));
+    Serial.print(tip.d);
+    Serial.print(F(", corr: "));
+    Serial.print(tip.tCorrection);
+    Serial.print(F(", max: "));
+    Serial.print(tip.maxPower);
+    Serial.print(F(", tau: "));
+    Serial.print(tip.tauHeater);
+    Serial.print('/');
+    Serial.print(tip.tauTip);
+    Serial.print(F(", gain: "));
+    Serial.print(tip.heaterGain);
+    Serial.print(F(", loss: "));
+    Serial.print(tip.tipLoss);
+    Serial.print(F(", ref: "));
+    Serial.print(tip.refGain);
+    Serial.print('/');
+    Serial.println(tip.refTau);
+  }
+}
+
+void serviceBoot() {
+  switch (bootStage) {
+  case BOOT_LOGO:
+    updateLCD();
+    logoMillis = millis16();
+    break;
+  case BOOT_BANNER:
+    if (Serial.availableForWrite() < 12) {
+      return; // try again next pass, never wait for the uart
+    }
+    Serial.println(F("* START *"));
+    break;
+  case BOOT_TUNINGS:
+    if (Serial.availableForWrite() < 48) {
+      return;
+    }
+    printTunnings();
+    break;
+  case BOOT_DEFAULTS:
+    if (isSavingDefaults) { // first boot only, the heater is already regulating
+      if (!saveDefaultsByte()) {
+        return; // a byte per pass, a write takes 3.3 ms
+      }
+      isSavingDefaults = false;
+    }
+    break;
+  case BOOT_BEEP:
+    beep();
+    break;
+  default:
+    return;
+  }
+  bootStage = (BOOT)(bootStage + 1);
+}
+
+void printBoot() {
+  Serial.print(F("Heater PWM period: "));
+  Serial.print(Board::Heater::periodMicros);
+  Serial.print(F(" us, first PWM: "));
+  Serial.print(firstPwmMicros);
+  Serial.print(F(" us, setpoint reached: "));
+  if (bootReadyMillis > 0) {
+    Serial.print(bootReadyMillis);
+    Serial.println(F(" ms"));
+  } else {
+    Serial.println(F("not yet"));
   }
 }
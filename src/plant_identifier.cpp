@@ -0,0 +1,138 @@
+#include "plant_identifier.h"
+
+#define RLS_FORGET_INVERSE ((int32_t)(RLS_ONE / RLS_FORGET))
+#define RLS_ERROR_MAX (4 * RLS_ONE)   // prediction error clamp, a glitch can't throw the model away
+#define RLS_THETA_MAX (100 * RLS_ONE)
+
+static int32_t mulq(int32_t a, int32_t b) {
+  return ((int64_t)a * b) >> RLS_Q;
+}
+
+static int32_t clampq(int32_t value, int32_t limit) {
+  return (value > limit) ? limit : (value < -limit) ? -limit : value;
+}
+
+PlantIdentifier::PlantIdentifier() {
+  reset();
+}
+
+void PlantIdentifier::reset() {
+  for (byte i = 0; i < RLS_PARAMS; i++) {
+    theta[i] = 0;
+    for (byte j = 0; j < RLS_PARAMS; j++) {
+      p[i][j] = (i == j) ? (int32_t)(RLS_P_START * RLS_ONE) : 0;
+    }
+  }
+  step = 0;
+  sampleCount = 0;
+  hasLast = false;
+  dutyIntegral = 0;
+  elapsed = 0;
+}
+
+void PlantIdentifier::update(double duty, double input, uint16_t dtMs) {
+  dutyIntegral += duty * dtMs;
+  elapsed += dtMs;
+  switch (step) {
+  case 0:
+    if (!hasLast || elapsed >= RLS_SAMPLE_PERIOD) {
+      latch(input);
+    }
+    break;
+  case 1:
+    stepGain();
+    break;
+  case 2:
+    stepParameters();
+    break;
+  case 3:
+    stepCovariance();
+    break;
+  }
+}
+
+void PlantIdentifier::latch(double input) {
+  if (hasLast) {
+    double slope = (input - lastInput) * 1000 / elapsed;
+    if (fabs(slope) < 256) { // faster is a sensor glitch, not the plant
+      phi[0] = dutyIntegral / elapsed * RLS_ONE;
+      phi[1] = ((input + lastInput) / 2 - OBSERVER_AMBIENT) / 512 * RLS_ONE;
+      target = slope / 256 * RLS_ONE;
+      step = 1;
+    }
+  }
+  hasLast = true;
+  lastInput = input;
+  dutyIntegral = 0;
+  elapsed = 0;
+}
+
+void PlantIdentifier::stepGain() {
+  // P * phi and the denominator of the gain
+  denominator = (int32_t)(RLS_FORGET * RLS_ONE);
+  for (byte i = 0; i < RLS_PARAMS; i++) {
+    pPhi[i] = mulq(p[i][0], phi[0]) + mulq(p[i][1], phi[1]);
+    denominator += mulq(phi[i], pPhi[i]);
+  }
+  step = 2;
+}
+
+void PlantIdentifier::stepParameters() {
+  // gain = P * phi / denominator, theta += gain * prediction error
+  // 32 bit division, denominator >= forget so the inverse fits, 1 count short at most
+  int32_t inverse = 0xFFFFFFFFUL / (uint32_t)denominator;
+  int32_t error = target;
+  for (byte i = 0; i < RLS_PARAMS; i++) {
+    error -= mulq(phi[i], theta[i]);
+  }
+  error = clampq(error, RLS_ERROR_MAX);
+  for (byte i = 0; i < RLS_PARAMS; i++) {
+    gainK[i] = mulq(pPhi[i], inverse);
+    theta[i] = clampq(theta[i] + mulq(gainK[i], error), RLS_THETA_MAX);
+  }
+  step = 3;
+}
+
+void PlantIdentifier::stepCovariance() {
+  // P = (P - gain * (P * phi)') / forget, upper triangle mirrored to keep it symmetric.
+  // Only samples with the temperature moving forget: sitting at the setpoint says nothing
+  // about tau and would slowly wash out what the last transient taught, and without
+  // excitation P would also grow without bound
+  bool forget = abs(target) > (int32_t)(RLS_EXCITATION / 256.0 * RLS_ONE) && trace() < RLS_TRACE_MAX;
+  for (byte i = 0; i < RLS_PARAMS; i++) {
+    for (byte j = i; j < RLS_PARAMS; j++) {
+      int32_t value = p[i][j] - mulq(gainK[i], pPhi[j]);
+      if (forget) {
+        value = mulq(value, RLS_FORGET_INVERSE);
+      }
+      if (i == j && value < 1) {
+        value = 1; // rounding must not leave a negative variance
+      }
+      p[i][j] = p[j][i] = value;
+    }
+  }
+  sampleCount++;
+  step = 0;
+}
+
+bool PlantIdentifier::isReady() {
+  double t = tau();
+  double g = gain();
+  return sampleCount >= RLS_MIN_SAMPLES && t >= RLS_TAU_MIN && t <= RLS_TAU_MAX && g >= RLS_GAIN_MIN &&
+         g <= RLS_GAIN_MAX;
+}
+
+double PlantIdentifier::tau() {
+  // b = -512 / (256 * tau)
+  double b = (double)theta[1] / RLS_ONE;
+  return (b < 0) ? -2 / b : 0;
+}
+
+double PlantIdentifier::gain() {
+  // a = gain / (256 * tau)
+  return 256 * tau() * theta[0] / RLS_ONE;
+}
+
+double PlantIdentifier::trace() {
+  return (double)(p[0][0] + p[1][1]) / RLS_ONE;
+}
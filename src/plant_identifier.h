@@ -0,0 +1,64 @@
+#ifndef PLANT_IDENTIFIER_H
+#define PLANT_IDENTIFIER_H
+
+#include <Arduino.h>
+#include "thermal_observer.h" // OBSERVER_AMBIENT
+
+#define RLS_PARAMS 2              // duty and temperature terms
+#define RLS_Q 16                  // fixed point fraction bits
+#define RLS_ONE (1L << RLS_Q)
+#define RLS_FORGET 0.998          // forgetting factor, about 500 samples of memory
+#define RLS_P_START 100.0         // initial covariance, large trusts the first samples
+#define RLS_TRACE_MAX 1000.0      // covariance trace above it stops forgetting
+#define RLS_EXCITATION 2.0        // Celsius/s, slower samples don't forget
+#define RLS_SAMPLE_PERIOD 250     // ms, minimum time between samples
+#define RLS_MIN_SAMPLES 100       // samples before the model is trusted
+#define RLS_TAU_MIN 1.0           // s, plausible time constant range
+#define RLS_TAU_MAX 300.0
+#define RLS_GAIN_MIN 50.0         // Celsius above ambient at full duty, plausible range
+#define RLS_GAIN_MAX 2000.0
+
+// Online identification of a first order thermal model of the iron:
+//   Input' = (gain * duty - (Input - ambient)) / tau
+// fitted with recursive least squares, in fixed point, as
+//   slope / 256 = a * duty + b * (Input - ambient) / 512
+// so every term stays within +-1. The ambient is taken as OBSERVER_AMBIENT, fitting it too
+// leaves the model drifting while the PID holds duty and temperature in step. Samples are
+// taken at least RLS_SAMPLE_PERIOD apart with the average duty and the mid temperature of
+// the interval, which keeps the fit right when the control period changes. One step of the
+// update runs per update() call, a sample takes three of them, so the cost per control tick
+// is bounded whatever the data.
+class PlantIdentifier {
+public:
+  PlantIdentifier();
+  void reset();
+  // every control tick, duty 0-1, Celsius, ms since the previous call
+  void update(double duty, double input, uint16_t dtMs);
+  bool isReady();             // enough samples and a plausible model
+  double gain();              // Celsius above ambient at full duty
+  double tau();               // s
+  uint32_t samples() { return sampleCount; }
+  double trace();             // covariance trace, high means poorly excited
+
+private:
+  int32_t theta[RLS_PARAMS];            // Q16
+  int32_t p[RLS_PARAMS][RLS_PARAMS];    // Q16, symmetric
+  int32_t phi[RLS_PARAMS];              // latched regressor, Q16
+  int32_t target;                       // latched slope / 256, Q16
+  int32_t pPhi[RLS_PARAMS];             // P * phi, Q16
+  int32_t gainK[RLS_PARAMS];            // RLS gain, Q16
+  int32_t denominator;                  // forget + phi' * P * phi, Q16
+  byte step;                            // 0 waiting for a sample, 1-3 update steps
+  uint32_t sampleCount;
+  bool hasLast;
+  double lastInput;
+  double dutyIntegral;                  // duty * ms since the last sample
+  uint16_t elapsed;                     // ms since the last sample
+
+  void latch(double input);
+  void stepGain();
+  void stepParameters();
+  void stepCovariance();
+};
+
+#endif
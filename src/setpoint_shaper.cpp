@@ -0,0 +1,61 @@
+#include "setpoint_shaper.h"
+
+SetpointShaper::SetpointShaper() {
+  profile = RAMP_STEP;
+  maxRate = 0;
+  accel = 0;
+  reset(0);
+}
+
+void SetpointShaper::configure(byte profile, double maxRate, double accel) {
+  this->profile = (maxRate > 0) ? profile : RAMP_STEP; // no rate means no ramp
+  this->maxRate = maxRate;
+  this->accel = accel;
+}
+
+void SetpointShaper::reset(double value) {
+  position = lastTarget = value;
+  velocity = 0;
+}
+
+double SetpointShaper::update(double target, double input, bool heaterLimited, uint16_t dtMs) {
+  lastTarget = target;
+  if (profile == RAMP_STEP || dtMs == 0) {
+    if (profile == RAMP_STEP) {
+      reset(target);
+    }
+    return position;
+  }
+
+  double dt = dtMs / 1000.0;
+  double distance = target - position;
+  double direction = (distance > 0) ? 1 : -1;
+  double oldPosition = position;
+
+  if (profile == RAMP_LINEAR) {
+    velocity = direction * maxRate;
+  } else {
+    // S-curve: accelerate up to maxRate and brake early enough to land on the target
+    double brakeSpeed = sqrt(2 * accel * fabs(distance));
+    double wanted = direction * min(maxRate, brakeSpeed);
+    double dv = accel * dt;
+    velocity = constrain(wanted, velocity - dv, velocity + dv);
+  }
+
+  position += velocity * dt;
+  if ((direction > 0 && position >= target) || (direction < 0 && position <= target)) {
+    reset(target);
+    return position;
+  }
+
+  // heater can't keep up, hold the trajectory just ahead of the real temperature
+  if (heaterLimited) {
+    if (direction > 0 && position > input + SHAPER_TRACK_MARGIN) {
+      position = max(oldPosition, input + SHAPER_TRACK_MARGIN);
+    } else if (direction < 0 && position < input - SHAPER_TRACK_MARGIN) {
+      position = min(oldPosition, input - SHAPER_TRACK_MARGIN);
+    }
+    velocity = (position - oldPosition) / dt;
+  }
+  return position;
+}
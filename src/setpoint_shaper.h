@@ -0,0 +1,35 @@
+#ifndef SETPOINT_SHAPER_H
+#define SETPOINT_SHAPER_H
+
+#include <Arduino.h>
+
+// how close (Celsius) the shaped setpoint may run ahead of a saturated heater
+#define SHAPER_TRACK_MARGIN 3.0
+
+enum RAMP { RAMP_STEP, RAMP_LINEAR, RAMP_SCURVE, RAMP_LENGHT };
+
+// Shapes the user setpoint into a trajectory the PID can follow without overshoot.
+// RAMP_STEP passes the target through, RAMP_LINEAR limits the slope to maxRate
+// and RAMP_SCURVE also limits the acceleration so the ramp starts and lands smoothly.
+// While the heater is saturated the trajectory is held just ahead of the measured
+// temperature, so it never runs faster than the heater can actually follow.
+class SetpointShaper {
+public:
+  SetpointShaper();
+  void configure(byte profile, double maxRate, double accel); // Celsius/s, Celsius/s^2
+  void reset(double value);                                   // jump to value, no ramp
+  // advances the trajectory by dtMs towards target, returns the shaped setpoint
+  // heaterLimited: true when the output is pinned at one of its limits
+  double update(double target, double input, bool heaterLimited, uint16_t dtMs);
+  bool isRamping() { return position != lastTarget; }
+
+private:
+  byte profile;
+  double maxRate;
+  double accel;
+  double position; // shaped setpoint
+  double velocity; // Celsius/s, signed
+  double lastTarget;
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef SETTINGS_FRAME_H
+#define SETTINGS_FRAME_H
+
+// Settings snapshot frames, shared by the firmware and tools/settings_cli.
+// One text line per frame: FRAME_START followed by hex bytes
+//   version | flags | length | payload | crc lo | crc hi
+// version is the EEPROM_CHECK of the firmware, the crc covers version to payload.
+// The payload is the raw eeprom_map_t, or with FRAME_TIP a slot byte and its raw tip_profile_t.
+// A clone is one tip frame per slot from slot 0, then the settings frame. The station only
+// stages the tip frames, the settings frame commits them with the settings and its persist
+// flag decides for all of it, a failed frame drops the clone. It covers the settings,
+// memories, standby ladder, active tip and every tip profile with its name, tunings and
+// identified model. The energy counters stay with the station.
+
+#include <stdint.h>
+
+#define FRAME_START '#'
+#define FRAME_HEADER_SIZE 3
+#define FRAME_PERSIST 0x01 // also save the settings to the eeprom
+#define FRAME_TIP 0x02     // the payload is a tip profile slot
+
+// crc-16 ccitt, same as avr-libc _crc_ccitt_update(), start with 0xFFFF
+static inline uint16_t frameCrc(uint16_t crc, uint8_t data) {
+  data ^= (uint8_t)(crc & 0xFF);
+  data ^= (uint8_t)(data << 4);
+  return ((((uint16_t)data << 8) | (crc >> 8)) ^ (uint8_t)(data >> 4) ^ ((uint16_t)data << 3));
+}
+
+static inline char frameHexDigit(uint8_t nibble) { return nibble < 10 ? '0' + nibble : 'A' + nibble - 10; }
+
+// returns the nibble value or -1 if c is not an hex digit
+static inline int8_t frameHexValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+#endif
@@ -0,0 +1,38 @@
+#include "thermal_observer.h"
+
+ThermalObserver::ThermalObserver() {
+  configure(0, 0, 0, 0);
+  reset(OBSERVER_AMBIENT, OBSERVER_AMBIENT);
+}
+
+void ThermalObserver::configure(double tauHeater, double tauTip, double gain, double loss) {
+  enabled = tauHeater > 0 && tauTip > 0 && gain > 0 && loss > 0;
+  this->tauHeater = tauHeater;
+  this->tauTip = tauTip;
+  this->gain = gain;
+  this->loss = loss;
+}
+
+void ThermalObserver::reset(double heater, double tip) {
+  heaterTemp = heater;
+  tipTemp = tip;
+}
+
+double ThermalObserver::update(double sensor, double duty, uint16_t dtMs) {
+  if (!enabled) {
+    return tipTemp;
+  }
+  double dt = dtMs / 1000.0;
+
+  // predict, euler steps no longer than the fastest time constant can take
+  double flow = heaterTemp - tipTemp;
+  heaterTemp += min(dt / tauHeater, 1.0) * (gain * duty - flow);
+  tipTemp += min(dt / tauTip, 1.0) * (flow - loss * (tipTemp - OBSERVER_AMBIENT));
+
+  // correct with the measured heater temperature, gains discretized so a longer period
+  // corrects more without ever taking the whole sensor error
+  double error = sensor - heaterTemp;
+  heaterTemp += (1 - exp(-OBSERVER_HEATER_GAIN * dt)) * error;
+  tipTemp += (1 - exp(-OBSERVER_TIP_GAIN * dt)) * error;
+  return tipTemp;
+}
@@ -0,0 +1,37 @@
+#ifndef THERMAL_OBSERVER_H
+#define THERMAL_OBSERVER_H
+
+#include <Arduino.h>
+
+#define OBSERVER_AMBIENT 25       // Celsius
+#define OBSERVER_HEATER_GAIN 2.0  // 1/s, how fast the heater estimate follows the sensor
+#define OBSERVER_TIP_GAIN 0.5     // 1/s, how much of a sensor surprise is blamed on the tip
+#define OBSERVER_TAU_MAX 300.0    // s, plausible model range, 0 is unknown
+#define OBSERVER_GAIN_MAX 2000.0  // Celsius at full duty
+#define OBSERVER_LOSS_MAX 10.0
+
+// Two node thermal model of the iron: the heater, where the thermistor sits, and the tip.
+//   heater' = (gain * duty - (heater - tip)) / tauHeater
+//   tip'    = ((heater - tip) - loss * (tip - ambient)) / tauTip
+// At rest with no load the tip settles at (heater + loss * ambient) / (1 + loss) and the heater
+// runs gain * duty above it. The model is run every control sample and corrected with the
+// measured heater temperature, so a solder joint pulling heat out of the tip shows up in the tip
+// estimate before the thermistor has cooled down. Parameters come from tools/observer_calibration,
+// which also fits the correction gains against a tip thermometer.
+class ThermalObserver {
+public:
+  ThermalObserver();
+  // seconds, seconds, Celsius at full duty, tip loss ratio; any of them 0 disables the observer
+  void configure(double tauHeater, double tauTip, double gain, double loss);
+  bool isEnabled() { return enabled; }
+  void reset(double heater, double tip);
+  // advances the model by dtMs with duty 0-1 and corrects it with the sensor, returns the tip estimate
+  double update(double sensor, double duty, uint16_t dtMs);
+
+private:
+  bool enabled;
+  double tauHeater, tauTip, gain, loss;
+  double heaterTemp, tipTemp;
+};
+
+#endif
@@ -0,0 +1,45 @@
+#include "thermistor.h"
+#include "config.h"
+
+#define THERM_ENTRY(n) Board::Sensor::adcSumAt((n) * THERM_TABLE_STEP)
+#define THERM_ROW(n)                                                                                                   \
+  THERM_ENTRY(n), THERM_ENTRY(n + 1), THERM_ENTRY(n + 2), THERM_ENTRY(n + 3), THERM_ENTRY(n + 4), THERM_ENTRY(n + 5), \
+      THERM_ENTRY(n + 6), THERM_ENTRY(n + 7), THERM_ENTRY(n + 8), THERM_ENTRY(n + 9)
+
+// ADC sum at 0, 10, 20 ... 500 Celsius, falls as the temperature rises
+const uint16_t thermistorTable[THERM_TABLE_SIZE] PROGMEM = {THERM_ROW(0),  THERM_ROW(10), THERM_ROW(20),
+                                                            THERM_ROW(30), THERM_ROW(40), THERM_ENTRY(50)};
+
+static_assert(THERM_TABLE_SIZE == 51, "THERM_ROW list covers 51 entries");
+static_assert(Board::Sensor::adcSumAt(0) > Board::Sensor::adcSumAt(THERM_TABLE_STEP), "table must fall with temperature");
+static_assert(Board::Sensor::adcSumAt((THERM_TABLE_SIZE - 2) * THERM_TABLE_STEP) >
+                  Board::Sensor::adcSumAt((THERM_TABLE_SIZE - 1) * THERM_TABLE_STEP),
+              "sensor has no resolution at the top of the table");
+
+double readThermistor() {
+  uint16_t sum = 0;
+  for (byte n = 0; n < Board::Sensor::samples; n++) {
+    sum += analogRead(Board::sensorPin);
+  }
+
+  if (sum > pgm_read_word(&thermistorTable[0])) {
+    return THERM_OPEN;
+  }
+  // binary search for the pair of entries around the reading
+  byte low = 0;
+  byte high = THERM_TABLE_SIZE - 1;
+  if (sum < pgm_read_word(&thermistorTable[high])) {
+    return THERM_SHORTED;
+  }
+  while (high - low > 1) {
+    byte middle = (low + high) / 2;
+    if (pgm_read_word(&thermistorTable[middle]) >= sum) {
+      low = middle;
+    } else {
+      high = middle;
+    }
+  }
+  uint16_t hot = pgm_read_word(&thermistorTable[high]);
+  uint16_t cold = pgm_read_word(&thermistorTable[low]);
+  return (low + (double)(cold - sum) / (cold - hot)) * THERM_TABLE_STEP;
+}
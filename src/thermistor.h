@@ -0,0 +1,11 @@
+#ifndef THERMISTOR_H
+#define THERMISTOR_H
+
+// Thermistor reading through a table the compiler builds from Board::Sensor,
+// no log() or float division at run time.
+#define THERM_OPEN -1     // reading colder than the table
+#define THERM_SHORTED 999 // reading hotter than the table, trips the over temperature cutoff at any correction
+
+double readThermistor(); // Celsius, THERM_OPEN or THERM_SHORTED outside the table
+
+#endif
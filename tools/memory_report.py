@@ -0,0 +1,50 @@
+# PlatformIO post build script: prints the static RAM footprint of the firmware
+# and appends it to memory_usage.csv so it can be tracked from build to build.
+# The dynamic part (stack high-water-mark, free RAM) is reported at runtime by the "m" serial command.
+import csv
+import os
+import subprocess
+import time
+
+Import("env")
+
+RAM_SIZE = 2048  # ATmega328
+
+
+def section_sizes(elf):
+    out = subprocess.check_output([env.subst("$SIZETOOL"), "-A", elf]).decode()
+    sizes = {}
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) >= 2 and parts[0].startswith(".") and parts[1].isdigit():
+            sizes[parts[0]] = int(parts[1])
+    return sizes
+
+
+def git_revision():
+    try:
+        return subprocess.check_output(["git", "rev-parse", "--short", "HEAD"],
+                                       cwd=env.subst("$PROJECT_DIR")).decode().strip()
+    except Exception:
+        return "unknown"
+
+
+def memory_report(source, target, env):
+    sizes = section_sizes(str(target[0]))
+    data, bss, text = sizes.get(".data", 0), sizes.get(".bss", 0), sizes.get(".text", 0)
+    static = data + bss
+    print("RAM: data %d + bss %d = %d bytes static, %d bytes left for heap/stack" %
+          (data, bss, static, RAM_SIZE - static))
+
+    # local history across builds and revisions, ignored by git
+    log = os.path.join(env.subst("$PROJECT_DIR"), "memory_usage.csv")
+    is_new = not os.path.exists(log)
+    with open(log, "a") as f:
+        writer = csv.writer(f)
+        if is_new:
+            writer.writerow(["date", "env", "revision", "text", "data", "bss", "static_ram"])
+        writer.writerow([time.strftime("%Y-%m-%d %H:%M:%S"), env.subst("$PIOENV"),
+                         git_revision(), text, data, bss, static])
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", memory_report)
@@ -0,0 +1,231 @@
+// Fits the two node thermal model of src/thermal_observer.h to a recorded log.
+//
+//   calibrate <log.csv> [tCorrection]
+//
+// Record the log with the "ol" serial command (ms,duty,sensor,tip per control sample) while
+// heating up, changing setpoints and soldering. A fifth column with a reference tip temperature
+// (tip thermometer) makes the tip node fit much better; without it the tip is pulled towards
+// tCorrection * sensor (default 0.85), which only pins down the steady state.
+// Prints the serial commands that store the fitted model in the active tip profile. With a
+// reference the observer correction gains are fitted too and printed next to the ones built
+// into the firmware.
+//
+// build: g++ -std=c++11 -O2 -o calibrate calibrate.cpp
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static const double AMBIENT = 25;       // OBSERVER_AMBIENT
+static const double HEATER_GAIN = 2.0; // OBSERVER_HEATER_GAIN
+static const double TIP_GAIN = 0.5;    // OBSERVER_TIP_GAIN
+static const double ESTIMATE_WEIGHT = 0.1; // weight of the tCorrection tip target when there is no reference
+
+struct Sample {
+  double ms, duty, sensor, reference;
+};
+
+struct Model {
+  double tauHeater, tauTip, gain, loss;
+};
+
+struct Gains {
+  double heater, tip; // 1/s
+};
+
+static bool hasReference;
+static double tCorrection = 0.85;
+
+static bool readLog(const char *path, std::vector<Sample> &log) {
+  std::ifstream file(path);
+  std::string line;
+  hasReference = true;
+  while (std::getline(file, line)) {
+    std::replace(line.begin(), line.end(), ',', ' ');
+    std::istringstream fields(line);
+    Sample s;
+    double tip;
+    if (!(fields >> s.ms >> s.duty >> s.sensor >> tip)) {
+      continue; // header or a command reply
+    }
+    if (!(fields >> s.reference)) {
+      hasReference = false;
+      s.reference = 0;
+    }
+    log.push_back(s);
+  }
+  return log.size() > 10;
+}
+
+// same update as ThermalObserver::update(), without gains runs the bare model
+static double simulate(const Model &m, const std::vector<Sample> &log, const Gains *gains, double *tipError) {
+  double heater = log[0].sensor;
+  double tip = hasReference ? log[0].reference : log[0].sensor * tCorrection;
+  double cost = 0, tipCost = 0;
+  for (size_t n = 1; n < log.size(); n++) {
+    double dt = (log[n].ms - log[n - 1].ms) / 1000.0;
+    double flow = heater - tip;
+    heater += std::min(dt / m.tauHeater, 1.0) * (m.gain * log[n - 1].duty - flow);
+    tip += std::min(dt / m.tauTip, 1.0) * (flow - m.loss * (tip - AMBIENT));
+    if (gains != NULL) {
+      double error = log[n].sensor - heater;
+      heater += (1 - std::exp(-gains->heater * dt)) * error;
+      tip += (1 - std::exp(-gains->tip * dt)) * error;
+    }
+    double target = hasReference ? log[n].reference : log[n].sensor * tCorrection;
+    double weight = hasReference ? 1.0 : ESTIMATE_WEIGHT;
+    cost += (log[n].sensor - heater) * (log[n].sensor - heater);
+    tipCost += (target - tip) * (target - tip);
+    cost += weight * (target - tip) * (target - tip);
+  }
+  if (tipError != NULL) {
+    *tipError = std::sqrt(tipCost / (log.size() - 1));
+  }
+  return cost / (log.size() - 1);
+}
+
+// parameters are fitted as logarithms so they stay positive
+static Model toModel(const double *x) {
+  Model m = {std::exp(x[0]), std::exp(x[1]), std::exp(x[2]), std::exp(x[3])};
+  return m;
+}
+
+static Gains toGains(const double *x) {
+  Gains g = {std::exp(x[0]), std::exp(x[1])};
+  return g;
+}
+
+// Nelder-Mead from start, leaves the best point in x
+template <int N, typename Cost> static void minimize(const double *start, Cost costOf, double *x) {
+  double simplex[N + 1][N];
+  double cost[N + 1];
+  for (int v = 0; v <= N; v++) {
+    for (int k = 0; k < N; k++) {
+      simplex[v][k] = start[k] + ((v == k + 1) ? 0.5 : 0);
+    }
+    cost[v] = costOf(simplex[v]);
+  }
+
+  for (int iteration = 0; iteration < 2000; iteration++) {
+    int order[N + 1];
+    for (int v = 0; v <= N; v++) {
+      order[v] = v;
+    }
+    std::sort(order, order + N + 1, [&](int a, int b) { return cost[a] < cost[b]; });
+    int best = order[0], worst = order[N], second = order[N - 1];
+    if (cost[worst] - cost[best] < 1e-9 * (1 + cost[best])) {
+      break;
+    }
+
+    double centroid[N] = {0};
+    for (int v = 0; v <= N; v++) {
+      if (v != worst) {
+        for (int k = 0; k < N; k++) {
+          centroid[k] += simplex[v][k] / N;
+        }
+      }
+    }
+    auto point = [&](double t, double *out) {
+      for (int k = 0; k < N; k++) {
+        out[k] = centroid[k] + t * (simplex[worst][k] - centroid[k]);
+      }
+      return costOf(out);
+    };
+
+    double reflected[N], other[N];
+    double reflectedCost = point(-1, reflected);
+    if (reflectedCost < cost[best]) {
+      double expandedCost = point(-2, other);
+      if (expandedCost < reflectedCost) {
+        std::copy(other, other + N, simplex[worst]);
+        cost[worst] = expandedCost;
+      } else {
+        std::copy(reflected, reflected + N, simplex[worst]);
+        cost[worst] = reflectedCost;
+      }
+    } else if (reflectedCost < cost[second]) {
+      std::copy(reflected, reflected + N, simplex[worst]);
+      cost[worst] = reflectedCost;
+    } else {
+      double contractedCost = point(0.5, other);
+      if (contractedCost < cost[worst]) {
+        std::copy(other, other + N, simplex[worst]);
+        cost[worst] = contractedCost;
+      } else { // shrink towards the best
+        for (int v = 0; v <= N; v++) {
+          if (v != best) {
+            for (int k = 0; k < N; k++) {
+              simplex[v][k] = simplex[best][k] + 0.5 * (simplex[v][k] - simplex[best][k]);
+            }
+            cost[v] = costOf(simplex[v]);
+          }
+        }
+      }
+    }
+  }
+  int best = std::min_element(cost, cost + N + 1) - cost;
+  std::copy(simplex[best], simplex[best] + N, x);
+}
+
+static Model fitModel(const std::vector<Sample> &log) {
+  const double start[4] = {std::log(2.0), std::log(5.0), std::log(100.0), std::log(0.2)};
+  double x[4];
+  minimize<4>(start, [&](const double *p) { return simulate(toModel(p), log, NULL, NULL); }, x);
+  return toModel(x);
+}
+
+// correction gains with the lowest tip error against the reference
+static Gains fitGains(const Model &m, const std::vector<Sample> &log) {
+  const double start[2] = {std::log(HEATER_GAIN), std::log(TIP_GAIN)};
+  double x[2];
+  minimize<2>(start,
+              [&](const double *p) {
+                Gains g = toGains(p);
+                double tipError;
+                simulate(m, log, &g, &tipError);
+                return tipError;
+              },
+              x);
+  return toGains(x);
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2 || argc > 3) {
+    std::cerr << "usage: " << argv[0] << " <log.csv> [tCorrection]" << std::endl;
+    return 2;
+  }
+  if (argc == 3) {
+    tCorrection = std::atof(argv[2]);
+  }
+  std::vector<Sample> log;
+  if (!readLog(argv[1], log)) {
+    std::cerr << argv[1] << ": not enough samples" << std::endl;
+    return 1;
+  }
+
+  Model m = fitModel(log);
+  const Gains firmware = {HEATER_GAIN, TIP_GAIN};
+  double modelTipError, observerTipError;
+  double modelCost = simulate(m, log, NULL, &modelTipError);
+  simulate(m, log, &firmware, &observerTipError);
+
+  std::printf("%zu samples, tip %s\n", log.size(), hasReference ? "reference from the log" : "estimated from tCorrection");
+  std::printf("model rms error %.2f C, tip rms error: model %.2f C, observer %.2f C\n", std::sqrt(modelCost),
+              modelTipError, observerTipError);
+  if (hasReference) {
+    // without a reference the tip target is the scaled sensor, the gains would just chase it
+    Gains g = fitGains(m, log);
+    double fittedTipError;
+    simulate(m, log, &g, &fittedTipError);
+    std::printf("fitted observer gains heater %.3f/s, tip %.3f/s (firmware %.3f/s, %.3f/s), tip rms error %.2f C\n",
+                g.heater, g.tip, HEATER_GAIN, TIP_GAIN, fittedTipError);
+  }
+  std::printf("th:%.3f\ntk:%.3f\ntg:%.2f\ntl:%.4f\n", m.tauHeater, m.tauTip, m.gain, m.loss);
+  return 0;
+}
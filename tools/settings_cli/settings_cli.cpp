@@ -0,0 +1,276 @@
+// Host side tool to clone a station, its settings and every tip profile, with one pull and one push.
+//
+//   settings_cli <port> pull <file>             save the station frames to file, one per line
+//   settings_cli <port> push <file> [--persist] apply the frames in file, --persist also saves them to eeprom
+//   settings_cli show <file>                    check a frame file and print the frame headers
+//
+// build: g++ -std=c++11 -O2 -o settings_cli settings_cli.cpp
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/select.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../../src/settings_frame.h"
+
+static const int BOOT_DELAY_MS = 2500; // the uno resets when the port is opened
+static const int REPLY_TIMEOUT_MS = 3000;
+
+// decodes a frame line, returns false with a reason if it is not a good frame
+static bool decodeFrame(const std::string &line, std::vector<uint8_t> &bytes, std::string &error) {
+  bytes.clear();
+  if (line.empty() || line[0] != FRAME_START || line.size() % 2 != 1) {
+    error = "not a settings frame";
+    return false;
+  }
+  for (size_t n = 1; n < line.size(); n += 2) {
+    int8_t high = frameHexValue(line[n]);
+    int8_t low = frameHexValue(line[n + 1]);
+    if (high < 0 || low < 0) {
+      error = "bad hex digit";
+      return false;
+    }
+    bytes.push_back((uint8_t)((high << 4) | low));
+  }
+  if (bytes.size() < FRAME_HEADER_SIZE + 2 || bytes.size() != (size_t)FRAME_HEADER_SIZE + bytes[2] + 2) {
+    error = "bad length";
+    return false;
+  }
+  uint16_t crc = 0xFFFF;
+  for (size_t n = 0; n < bytes.size() - 2; n++) {
+    crc = frameCrc(crc, bytes[n]);
+  }
+  if (crc != (bytes[bytes.size() - 2] | (bytes[bytes.size() - 1] << 8))) {
+    error = "crc mismatch";
+    return false;
+  }
+  return true;
+}
+
+static std::string encodeFrame(std::vector<uint8_t> bytes) {
+  uint16_t crc = 0xFFFF;
+  for (size_t n = 0; n < bytes.size() - 2; n++) {
+    crc = frameCrc(crc, bytes[n]);
+  }
+  bytes[bytes.size() - 2] = crc & 0xFF;
+  bytes[bytes.size() - 1] = crc >> 8;
+
+  std::string line(1, FRAME_START);
+  for (uint8_t b : bytes) {
+    line += frameHexDigit(b >> 4);
+    line += frameHexDigit(b & 0x0F);
+  }
+  return line;
+}
+
+static int openPort(const char *path) {
+  int fd = open(path, O_RDWR | O_NOCTTY);
+  if (fd < 0) {
+    perror(path);
+    return -1;
+  }
+  termios tty;
+  tcgetattr(fd, &tty);
+  cfmakeraw(&tty);
+  cfsetispeed(&tty, B115200); // SERIAL_BAUD
+  cfsetospeed(&tty, B115200);
+  tty.c_cflag |= CLOCAL | CREAD;
+  tcsetattr(fd, TCSANOW, &tty);
+  usleep(BOOT_DELAY_MS * 1000);
+  tcflush(fd, TCIFLUSH); // drop the boot banner
+  return fd;
+}
+
+// reads one line, false on timeout
+static bool readLine(int fd, std::string &line, int timeoutMs) {
+  line.clear();
+  for (;;) {
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(fd, &set);
+    timeval tv = {timeoutMs / 1000, (timeoutMs % 1000) * 1000};
+    if (select(fd + 1, &set, NULL, NULL, &tv) <= 0) {
+      return false;
+    }
+    char c;
+    if (read(fd, &c, 1) != 1) {
+      return false;
+    }
+    if (c == '\n') {
+      return true;
+    }
+    if (c != '\r') {
+      line += c;
+    }
+  }
+}
+
+// waits for the next line starting with FRAME_START
+static bool readFrame(int fd, std::string &reply) {
+  while (readLine(fd, reply, REPLY_TIMEOUT_MS)) {
+    if (!reply.empty() && reply[0] == FRAME_START) {
+      return true;
+    }
+  }
+  std::cerr << "no reply from the station" << std::endl;
+  return false;
+}
+
+// sends a line and waits for the reply line starting with FRAME_START
+static bool exchange(int fd, const std::string &request, std::string &reply) {
+  std::string out = request + "\n";
+  if (write(fd, out.data(), out.size()) != (ssize_t)out.size()) {
+    perror("write");
+    return false;
+  }
+  return readFrame(fd, reply);
+}
+
+// reads every frame line of a file, false if any of them is bad or there is none
+static bool readFrameFile(const char *path, std::vector<std::vector<uint8_t> > &frames) {
+  std::ifstream file(path);
+  std::string line, error;
+  frames.clear();
+  while (std::getline(file, line)) {
+    if (!line.empty() && line[line.size() - 1] == '\r') {
+      line.erase(line.size() - 1);
+    }
+    if (line.empty()) {
+      continue;
+    }
+    std::vector<uint8_t> bytes;
+    if (!decodeFrame(line, bytes, error)) {
+      std::cerr << path << ": line " << frames.size() + 1 << ": " << error << std::endl;
+      return false;
+    }
+    frames.push_back(bytes);
+  }
+  if (frames.empty()) {
+    std::cerr << path << ": no frames" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static int pull(const char *port, const char *path) {
+  int fd = openPort(port);
+  if (fd < 0) {
+    return 1;
+  }
+  // the station sends the tip frames then the settings frame, which ends the clone
+  std::vector<std::string> lines;
+  std::string reply, error;
+  std::vector<uint8_t> bytes;
+  bool ok = exchange(fd, "g", reply);
+  while (ok) {
+    if (!decodeFrame(reply, bytes, error)) {
+      std::cerr << "station sent a bad frame: " << error << std::endl;
+      ok = false;
+      break;
+    }
+    lines.push_back(reply);
+    if (!(bytes[1] & FRAME_TIP)) {
+      break;
+    }
+    ok = readFrame(fd, reply);
+  }
+  close(fd);
+  if (!ok) {
+    return 1;
+  }
+  std::ofstream file(path);
+  for (size_t n = 0; n < lines.size(); n++) {
+    file << lines[n] << std::endl;
+  }
+  std::cout << "saved the settings and " << lines.size() - 1 << " tip profiles (version " << (int)bytes[0] << ") to "
+            << path << std::endl;
+  return 0;
+}
+
+// sort key of a frame in a push, tip slots first then the settings
+static int frameRank(const std::vector<uint8_t> &bytes) {
+  return (bytes[1] & FRAME_TIP) ? bytes[FRAME_HEADER_SIZE] : 0x100;
+}
+
+static bool frameOrder(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b) {
+  return frameRank(a) < frameRank(b);
+}
+
+static int push(const char *port, const char *path, bool persist) {
+  std::vector<std::vector<uint8_t> > frames;
+  if (!readFrameFile(path, frames)) {
+    return 1;
+  }
+  // tip frames from slot 0, which starts a clone, then the settings frame that commits it
+  std::vector<std::vector<uint8_t> > ordered(frames);
+  std::stable_sort(ordered.begin(), ordered.end(), frameOrder);
+
+  int fd = openPort(port);
+  if (fd < 0) {
+    return 1;
+  }
+  int result = 0;
+  for (size_t n = 0; n < ordered.size() && result == 0; n++) {
+    std::vector<uint8_t> &bytes = ordered[n];
+    bytes[1] = persist ? (bytes[1] | FRAME_PERSIST) : (bytes[1] & ~FRAME_PERSIST);
+    std::string reply;
+    if (!exchange(fd, encodeFrame(bytes), reply)) {
+      result = 1;
+    } else {
+      if (bytes[1] & FRAME_TIP) {
+        std::cout << "tip " << (int)bytes[FRAME_HEADER_SIZE] << ": " << reply << std::endl;
+      } else {
+        std::cout << "settings: " << reply << std::endl;
+      }
+      result = reply == "#OK" ? 0 : 1;
+    }
+  }
+  close(fd);
+  return result;
+}
+
+static int show(const char *path) {
+  std::vector<std::vector<uint8_t> > frames;
+  if (!readFrameFile(path, frames)) {
+    return 1;
+  }
+  for (size_t n = 0; n < frames.size(); n++) {
+    const std::vector<uint8_t> &bytes = frames[n];
+    if (bytes[1] & FRAME_TIP) {
+      std::printf("version %d, flags 0x%02X, %d bytes of tip %d, crc ok\n", bytes[0], bytes[1], bytes[2],
+                  bytes[FRAME_HEADER_SIZE]);
+    } else {
+      std::printf("version %d, flags 0x%02X, %d bytes of settings, crc ok\n", bytes[0], bytes[1], bytes[2]);
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc == 3 && std::strcmp(argv[1], "show") == 0) {
+    return show(argv[2]);
+  }
+  if (argc == 4 && std::strcmp(argv[2], "pull") == 0) {
+    return pull(argv[1], argv[3]);
+  }
+  if ((argc == 4 || argc == 5) && std::strcmp(argv[2], "push") == 0) {
+    bool persist = argc == 5 && std::strcmp(argv[4], "--persist") == 0;
+    if (argc == 5 && !persist) {
+      std::cerr << "unknown option " << argv[4] << std::endl;
+      return 2;
+    }
+    return push(argv[1], argv[3], persist);
+  }
+  std::cerr << "usage: " << argv[0] << " <port> pull <file>" << std::endl
+            << "       " << argv[0] << " <port> push <file> [--persist]" << std::endl
+            << "       " << argv[0] << " show <file>" << std::endl;
+  return 2;
+}
@@ -0,0 +1,386 @@
+// Runs the real env:uno_bench firmware in simavr and reports its cycle costs as JSON.
+//
+//   simavr_bench <firmware.elf> [script] [--ms <simulated ms>] [--screen <file.pbm>]
+//
+// The heater and thermistor are a first order thermal model fed from the heater PWM and
+// read back through the ADC, the display is a PCD8544 sink on the SPI bus, and the script
+// drives the encoder and the serial port. Stage cycles come from the BENCH_MARK writes of
+// src/bench.h, interrupt time is counted apart from the stage it landed in.
+//
+// script lines, ms since power up, in order:
+//   <ms> enc <notches>   turns the encoder, negative is counter clockwise
+//   <ms> click           clicks the encoder button
+//   <ms> serial <text>   sends a line to the serial port
+//
+// build: pio run -e uno_bench
+//        g++ -std=c++11 -O2 -o simavr_bench simavr_bench.cpp -lsimavr -lelf
+// run:   ./simavr_bench ../../.pio/build/uno_bench/firmware.elf default.script > bench.json
+
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_irq.h>
+#include <simavr/sim_cycle_timers.h>
+#include <simavr/avr_adc.h>
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_spi.h>
+#include <simavr/avr_uart.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "../../src/bench.h"
+
+static const uint32_t F_CPU_HZ = 16000000;
+static const int VECTORS_BYTES = 26 * 4; // atmega328p interrupt vector table
+
+// UnoUsbIron in src/config.h
+static const double SERIES = 4700;
+static const double NOMINAL = 100000;
+static const double BETA = 3950;
+static const double NOMINAL_TEMP = 25;
+static const uint32_t VCC_MV = 5000;
+
+// thermal model, Celsius above ambient at full duty and seconds
+static const double AMBIENT = 25;
+static const double PLANT_GAIN = 450;
+static const double PLANT_TAU = 12;
+
+// data space addresses, heater on pin 3, OC2B
+static const uint16_t TCCR2A_ADDR = 0xB0;
+static const uint16_t OCR2B_ADDR = 0xB4;
+static const uint16_t PORTD_ADDR = 0x2B;
+static const uint8_t COM2B1_BIT = 5;
+static const uint8_t HEATER_PORTD_BIT = 3;
+
+static const char *const STAGE_NAMES[BENCH_STAGES] = {"setup",   "serial", "rotary", "boot",       "standby",
+                                                      "control", "energy", "lcd",    "housekeeping"};
+
+struct StageStats {
+  uint64_t calls, total, max;
+};
+
+struct Bench {
+  avr_t *avr;
+
+  // stages
+  uint8_t stage;
+  uint64_t stageStart, stageIsrStart;
+  StageStats stages[BENCH_STAGES];
+  uint64_t loopStart, loops, loopMax;
+
+  // interrupts
+  bool inIsr;
+  uint64_t isrStart, isrCount, isrTotal, isrMax;
+
+  // stack, lowest stack pointer seen
+  uint16_t spMin;
+
+  // plant
+  double temperature;
+  avr_irq_t *adcIrq;
+
+  // PCD8544 sink
+  bool dataMode, extended;
+  uint8_t x, y;
+  uint8_t ram[6 * 84];
+  uint64_t spiBytes, lcdBytes, lcdRefreshes;
+
+  // script
+  avr_irq_t *encoderA, *encoderB, *button, *uartIn;
+  std::deque<int> encoderSteps; // +1/-1 quadrature transitions still to play
+  uint8_t encoderPhase;
+};
+
+static Bench bench;
+
+static uint64_t ms(uint32_t value) { return (uint64_t)value * (F_CPU_HZ / 1000); }
+
+static void markStage(struct avr_t *avr, avr_io_addr_t addr, uint8_t value, void *param) {
+  avr->data[addr] = value;
+  uint64_t now = avr->cycle;
+  if (bench.stage < BENCH_STAGES) {
+    StageStats &s = bench.stages[bench.stage];
+    uint64_t cycles = (now - bench.stageStart) - (bench.isrTotal - bench.stageIsrStart);
+    s.calls++;
+    s.total += cycles;
+    if (cycles > s.max) {
+      s.max = cycles;
+    }
+  }
+  if (value == BENCH_SERIAL) {
+    if (bench.loops > 0 && now - bench.loopStart > bench.loopMax) {
+      bench.loopMax = now - bench.loopStart;
+    }
+    bench.loopStart = now;
+    bench.loops++;
+  }
+  if (value == BENCH_LCD) {
+    bench.lcdBytes = 0;
+  } else if (bench.stage == BENCH_LCD && bench.lcdBytes > 0) {
+    bench.lcdRefreshes++;
+  }
+  bench.stage = value;
+  bench.stageStart = now;
+  bench.stageIsrStart = bench.isrTotal;
+}
+
+static double heaterDuty(avr_t *avr) {
+  // analogWrite() 0 and 255 disconnect the PWM and drive the pin
+  if (avr->data[TCCR2A_ADDR] & (1 << COM2B1_BIT)) {
+    return avr->data[OCR2B_ADDR] / 255.0;
+  }
+  return (avr->data[PORTD_ADDR] & (1 << HEATER_PORTD_BIT)) ? 1.0 : 0.0;
+}
+
+static avr_cycle_count_t stepPlant(struct avr_t *avr, avr_cycle_count_t when, void *param) {
+  double dt = 0.001;
+  bench.temperature += dt * (PLANT_GAIN * heaterDuty(avr) - (bench.temperature - AMBIENT)) / PLANT_TAU;
+  // thermistor to ground, series resistor to the reference
+  double r = NOMINAL * std::exp(BETA * (1 / (bench.temperature + 273.15) - 1 / (NOMINAL_TEMP + 273.15)));
+  avr_raise_irq(bench.adcIrq, (uint32_t)(VCC_MV * r / (r + SERIES)));
+  return when + avr_usec_to_cycles(avr, 1000);
+}
+
+static void spiOutput(struct avr_irq_t *irq, uint32_t value, void *param) {
+  uint8_t b = value;
+  bench.spiBytes++;
+  if (bench.dataMode) {
+    bench.ram[bench.y * 84 + bench.x] = b;
+    bench.lcdBytes++;
+    if (++bench.x >= 84) {
+      bench.x = 0;
+      bench.y = (bench.y + 1) % 6;
+    }
+  } else if ((b & 0xF8) == 0x20) { // function set
+    bench.extended = b & 1;
+  } else if (!bench.extended && (b & 0xF8) == 0x40) {
+    bench.y = (b & 7) % 6;
+  } else if (!bench.extended && (b & 0x80)) {
+    bench.x = (b & 0x7F) % 84;
+  }
+}
+
+static void lcdA0(struct avr_irq_t *irq, uint32_t value, void *param) { bench.dataMode = value; }
+
+static void uartOutput(struct avr_irq_t *irq, uint32_t value, void *param) { std::fputc(value, stderr); }
+
+static avr_cycle_count_t stepEncoder(struct avr_t *avr, avr_cycle_count_t when, void *param) {
+  if (bench.encoderSteps.empty()) {
+    return 0;
+  }
+  // active low gray code, idle with both pins high
+  static const uint8_t GRAY[4] = {3, 1, 0, 2};
+  bench.encoderPhase = (bench.encoderPhase + bench.encoderSteps.front()) & 3;
+  bench.encoderSteps.pop_front();
+  avr_raise_irq(bench.encoderA, (GRAY[bench.encoderPhase] >> 1) & 1);
+  avr_raise_irq(bench.encoderB, GRAY[bench.encoderPhase] & 1);
+  return when + avr_usec_to_cycles(avr, 2000); // the encoder is sampled every ms
+}
+
+static avr_cycle_count_t releaseButton(struct avr_t *avr, avr_cycle_count_t when, void *param) {
+  avr_raise_irq(bench.button, 1);
+  return 0;
+}
+
+static void runCommand(const std::string &command, const std::string &argument) {
+  if (command == "enc") {
+    int notches = std::atoi(argument.c_str());
+    bool idle = bench.encoderSteps.empty();
+    for (int n = 0; n < 4 * std::abs(notches); n++) {
+      bench.encoderSteps.push_back(notches > 0 ? 1 : -1);
+    }
+    if (idle) {
+      avr_cycle_timer_register_usec(bench.avr, 1, stepEncoder, NULL);
+    }
+  } else if (command == "click") {
+    avr_raise_irq(bench.button, 0);
+    avr_cycle_timer_register_usec(bench.avr, 60000, releaseButton, NULL);
+  } else if (command == "serial") {
+    for (size_t n = 0; n < argument.size(); n++) {
+      avr_raise_irq(bench.uartIn, (uint8_t)argument[n]);
+    }
+    avr_raise_irq(bench.uartIn, '\n');
+  } else {
+    std::cerr << "unknown script command " << command << std::endl;
+  }
+}
+
+static void printStage(const char *name, const StageStats &s, bool last) {
+  std::printf("    \"%s\": {\"calls\": %llu, \"total_cycles\": %llu, \"avg_cycles\": %llu, \"max_cycles\": %llu}%s\n",
+              name, (unsigned long long)s.calls, (unsigned long long)s.total,
+              (unsigned long long)(s.calls > 0 ? s.total / s.calls : 0), (unsigned long long)s.max, last ? "" : ",");
+}
+
+static void writeScreen(const char *path) {
+  std::ofstream out(path);
+  out << "P1\n84 48\n";
+  for (int row = 0; row < 48; row++) {
+    for (int column = 0; column < 84; column++) {
+      out << ((bench.ram[(row / 8) * 84 + column] >> (row % 8)) & 1) << (column < 83 ? " " : "\n");
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  const char *elfPath = NULL;
+  const char *scriptPath = NULL;
+  const char *screenPath = NULL;
+  uint32_t runMs = 20000;
+  for (int n = 1; n < argc; n++) {
+    if (std::strcmp(argv[n], "--ms") == 0 && n + 1 < argc) {
+      runMs = std::strtoul(argv[++n], NULL, 10);
+    } else if (std::strcmp(argv[n], "--screen") == 0 && n + 1 < argc) {
+      screenPath = argv[++n];
+    } else if (!elfPath) {
+      elfPath = argv[n];
+    } else if (!scriptPath) {
+      scriptPath = argv[n];
+    } else {
+      elfPath = NULL;
+      break;
+    }
+  }
+  if (!elfPath) {
+    std::cerr << "usage: " << argv[0] << " <firmware.elf> [script] [--ms <simulated ms>] [--screen <file.pbm>]"
+              << std::endl;
+    return 2;
+  }
+
+  elf_firmware_t firmware;
+  std::memset(&firmware, 0, sizeof(firmware));
+  if (elf_read_firmware(elfPath, &firmware) != 0) {
+    std::cerr << "can't read " << elfPath << std::endl;
+    return 1;
+  }
+  std::strcpy(firmware.mmcu, "atmega328p"); // the arduino elf doesn't carry it
+  firmware.frequency = F_CPU_HZ;
+
+  avr_t *avr = avr_make_mcu_by_name(firmware.mmcu);
+  if (!avr) {
+    std::cerr << "simavr has no atmega328p" << std::endl;
+    return 1;
+  }
+  avr_init(avr);
+  avr_load_firmware(avr, &firmware);
+  avr->vcc = avr->avcc = avr->aref = VCC_MV;
+  bench.avr = avr;
+  bench.spMin = 0xFFFF;
+  bench.temperature = AMBIENT;
+
+  avr_register_io_write(avr, BENCH_MARK_ADDRESS, markStage, NULL);
+
+  bench.adcIrq = avr_io_getirq(avr, AVR_IOCTL_ADC_GETIRQ, ADC_IRQ_ADC0);
+  avr_cycle_timer_register_usec(avr, 1000, stepPlant, NULL);
+
+  avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_SPI_GETIRQ(0), SPI_IRQ_OUTPUT), spiOutput, NULL);
+  avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), 1), lcdA0, NULL); // pin 9
+
+  // serial output goes to stderr, stdout is the report
+  uint32_t flags = 0;
+  avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS('0'), &flags);
+  flags &= ~AVR_UART_FLAG_STDIO;
+  avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS('0'), &flags);
+  avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT), uartOutput, NULL);
+  bench.uartIn = avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_INPUT);
+
+  // encoder on A1, A2 and A3 with pull ups
+  bench.encoderA = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('C'), 1);
+  bench.encoderB = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('C'), 2);
+  bench.button = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('C'), 3);
+  avr_raise_irq(bench.encoderA, 1);
+  avr_raise_irq(bench.encoderB, 1);
+  avr_raise_irq(bench.button, 1);
+
+  std::ifstream script;
+  if (scriptPath) {
+    script.open(scriptPath);
+    if (!script) {
+      std::cerr << "can't read " << scriptPath << std::endl;
+      return 1;
+    }
+  }
+  uint32_t eventMs = 0;
+  std::string command, argument;
+  bool hasEvent = false;
+
+  int state = cpu_Running;
+  while (avr->cycle < ms(runMs)) {
+    // next script event
+    while (!hasEvent && script.is_open() && !script.eof()) {
+      std::string line;
+      std::getline(script, line);
+      std::istringstream fields(line);
+      if (line.empty() || line[0] == '#' || !(fields >> eventMs >> command)) {
+        continue;
+      }
+      std::getline(fields >> std::ws, argument);
+      hasEvent = true;
+    }
+    if (hasEvent && avr->cycle >= ms(eventMs)) {
+      runCommand(command, argument);
+      hasEvent = false;
+    }
+
+    state = avr_run(avr);
+    if (state == cpu_Done || state == cpu_Crashed) {
+      break;
+    }
+
+    // an interrupt clears I and lands on its vector, reti sets I again
+    bool enabled = avr->sreg[S_I];
+    if (!bench.inIsr && !enabled && avr->pc > 0 && avr->pc < VECTORS_BYTES) {
+      bench.inIsr = true;
+      bench.isrStart = avr->cycle;
+    } else if (bench.inIsr && enabled) {
+      uint64_t cycles = avr->cycle - bench.isrStart;
+      bench.inIsr = false;
+      bench.isrCount++;
+      bench.isrTotal += cycles;
+      if (cycles > bench.isrMax) {
+        bench.isrMax = cycles;
+      }
+    }
+    uint16_t sp = avr->data[R_SPL] | (avr->data[R_SPH] << 8);
+    if (sp < bench.spMin) {
+      bench.spMin = sp;
+    }
+  }
+
+  uint32_t ramEnd = avr->ramend;
+  uint32_t stack = ramEnd - bench.spMin;
+  uint32_t staticRam = firmware.datasize + firmware.bsssize;
+  std::printf("{\n");
+  std::printf("  \"firmware\": \"%s\",\n", elfPath);
+  std::printf("  \"mcu\": \"%s\",\n  \"f_cpu\": %u,\n", firmware.mmcu, F_CPU_HZ);
+  std::printf("  \"simulated_ms\": %llu,\n", (unsigned long long)(avr->cycle / (F_CPU_HZ / 1000)));
+  std::printf("  \"crashed\": %s,\n", state == cpu_Crashed ? "true" : "false");
+  std::printf("  \"loops\": %llu,\n", (unsigned long long)bench.loops);
+  std::printf("  \"loop_max_cycles\": %llu,\n  \"loop_max_us\": %.1f,\n", (unsigned long long)bench.loopMax,
+              bench.loopMax * 1e6 / F_CPU_HZ);
+  std::printf("  \"stages\": {\n");
+  for (int n = 0; n < BENCH_STAGES; n++) {
+    printStage(STAGE_NAMES[n], bench.stages[n], n == BENCH_STAGES - 1);
+  }
+  std::printf("  },\n");
+  std::printf("  \"isr\": {\"count\": %llu, \"total_cycles\": %llu, \"max_cycles\": %llu, \"cpu_percent\": %.2f},\n",
+              (unsigned long long)bench.isrCount, (unsigned long long)bench.isrTotal,
+              (unsigned long long)bench.isrMax, avr->cycle > 0 ? 100.0 * bench.isrTotal / avr->cycle : 0);
+  std::printf("  \"ram\": {\"static_bytes\": %u, \"stack_max_bytes\": %u, \"high_water_bytes\": %u, \"size\": %u},\n",
+              staticRam, stack, staticRam + stack, ramEnd + 1 - 0x100);
+  std::printf("  \"lcd\": {\"refreshes\": %llu, \"spi_bytes\": %llu},\n", (unsigned long long)bench.lcdRefreshes,
+              (unsigned long long)bench.spiBytes);
+  std::printf("  \"plant\": {\"final_celsius\": %.1f}\n", bench.temperature);
+  std::printf("}\n");
+
+  if (screenPath) {
+    writeScreen(screenPath);
+  }
+  return state == cpu_Crashed ? 1 : 0;
+}